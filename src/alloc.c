@@ -1,107 +1,366 @@
 /*
- a proxy allocator providing malloc api on top of sdk for auditing memory,
- only single threaded at the moment.
+ allocator for the yyjson docs of a run. small blocks are carved from large
+ slabs and big ones come from the heap on their own, every block starts with
+ a header that has its size and slab so a free looks nothing up. a slab is
+ used again once all of its blocks are freed, alc_reset drops everything at
+ once when a run starts. slabs and big blocks are taken from the sdk heap
+ under the name of the allocator so its bytes are still audited by name,
+ blocks are counted in the memory audit too. a mutex guards the slabs, a doc
+ built on a task is freed on the gui thread.
 */
 #include "kt.h"
 
 #include <yyjson.h>
 
 #define MAX_NAME_LEN 10
+/* size of a slab and the largest block carved from one */
+#define ALC_SLAB (1024 * 1024)
+#define ALC_BIG (64 * 1024)
+#define ALC_ALIGN 16
+#define ALC_ROUND(size) (((size) + ALC_ALIGN - 1) & ~(size_t)(ALC_ALIGN - 1))
 
-typedef struct _addr_t addr;
+typedef struct _slab_t slab;
+typedef struct _block_t block;
+typedef struct _big_t big;
 typedef struct _context_t context;
 
-struct _addr_t
+struct _slab_t
+{
+    slab *prev;
+    slab *next;
+    uint32_t used;
+    /* bytes of its blocks that aren't freed yet */
+    uint32_t live;
+};
+
+/* right before every block handed out */
+struct _block_t
 {
-    void *ptr;
     size_t size;
+    /* NULL for a big block */
+    slab *owner;
+};
+
+struct _big_t
+{
+    big *prev;
+    big *next;
+    block head;
 };
-DeclSt(addr);
 
 struct _context_t
 {
     char_t name[MAX_NAME_LEN];
-    SetSt(addr) *set;
+    mem_t mem;
+    Mutex *mutex;
+    /* audited bytes, given back at once by a reset */
+    size_t live;
+    /* blocks are carved from cur, the others still have some in use */
+    slab *cur;
+    slab *full;
+    /* one empty slab kept for the next one needed */
+    slab *spare;
+    big *big;
 };
 
-static void *sdk_malloc(void *ctx, size_t size)
+#define SLAB_HEAD ALC_ROUND(sizeof(slab))
+#define SLAB_DATA (ALC_SLAB - SLAB_HEAD)
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE uint32_t i_carved(const size_t size)
 {
+    return (uint32_t)ALC_ROUND(sizeof(block) + size);
+}
 
-    context *ct = cast(ctx, context);
-    addr *val, key;
-    void *ptr = heap_malloc_imp(size, ct->name, FALSE);
-
-    key.ptr = ptr;
-    val = setst_insert(ct->set, &key, addr, addr);
-    if (!val)
-        val = setst_get(ct->set, &key, addr, addr);
-    val->ptr = ptr;
-    val->size = size;
-    return ptr;
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE byte_t *i_data(slab *sl)
+{
+    return cast(sl, byte_t) + SLAB_HEAD;
 }
 
-static void *sdk_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+/*---------------------------------------------------------------------------*/
+
+static void i_slab_free(context *ct, slab *sl)
 {
-    context *ct = cast(ctx, context);
-    addr *val, key;
-    void *newptr = heap_realloc(ptr, old_size, size, cast(ctx, context)->name);
+    heap_free(dcast(&sl, byte_t), ALC_SLAB, ct->name);
+}
+
+/*---------------------------------------------------------------------------*/
 
-    key.ptr = ptr;
-    if (ptr == newptr)
+static void i_unlink(context *ct, slab *sl)
+{
+    if (sl->prev)
+        sl->prev->next = sl->next;
+    else
+        ct->full = sl->next;
+    if (sl->next)
+        sl->next->prev = sl->prev;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* an empty slab is kept as the spare or given back */
+static void i_empty(context *ct, slab *sl)
+{
+    if (ct->spare == NULL)
+        ct->spare = sl;
+    else
+        i_slab_free(ct, sl);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* cur is full, a new one takes its place */
+static void i_next(context *ct)
+{
+    slab *sl = ct->cur;
+    if (sl && sl->live == 0)
+    {
+        i_empty(ct, sl);
+    }
+    else if (sl)
     {
-        val = setst_get(ct->set, &key, addr, addr);
-        cassert_no_null(val);
+        sl->prev = NULL;
+        sl->next = ct->full;
+        if (ct->full)
+            ct->full->prev = sl;
+        ct->full = sl;
+    }
+
+    if (ct->spare)
+    {
+        sl = ct->spare;
+        ct->spare = NULL;
     }
     else
     {
-        setst_delete(ct->set, &key, NULL, addr, addr);
-        key.ptr = newptr;
-        val = setst_insert(ct->set, &key, addr, addr);
-        val->ptr = newptr;
+        sl = cast(heap_malloc_imp(ALC_SLAB, ct->name, FALSE), slab);
     }
-    val->size = size;
+
+    sl->prev = NULL;
+    sl->next = NULL;
+    sl->used = 0;
+    sl->live = 0;
+    ct->cur = sl;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_resize(context *ct, const size_t old_size, const size_t size)
+{
+    ct->live = ct->live - old_size + size;
+    audit_free(ct->mem, old_size);
+    audit_alloc(ct->mem, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void *i_malloc(context *ct, size_t size)
+{
+    block *bl;
+    if (size > ALC_BIG)
+    {
+        big *bg = cast(heap_malloc_imp((uint32_t)(sizeof(big) + size), ct->name, FALSE), big);
+        bg->prev = NULL;
+        bg->next = ct->big;
+        if (ct->big)
+            ct->big->prev = bg;
+        ct->big = bg;
+        bl = &bg->head;
+        bl->owner = NULL;
+    }
+    else
+    {
+        uint32_t n = i_carved(size);
+        if (ct->cur == NULL || ct->cur->used + n > SLAB_DATA)
+            i_next(ct);
+        bl = cast(i_data(ct->cur) + ct->cur->used, block);
+        bl->owner = ct->cur;
+        ct->cur->used += n;
+        ct->cur->live += n;
+    }
+
+    bl->size = size;
+    ct->live += size;
+    audit_alloc(ct->mem, size);
+    return bl + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_free(context *ct, void *ptr)
+{
+    block *bl = cast(ptr, block) - 1;
+    ct->live -= bl->size;
+    audit_free(ct->mem, bl->size);
+    if (bl->owner == NULL)
+    {
+        big *bg = cast(cast(bl, byte_t) - (sizeof(big) - sizeof(block)), big);
+        if (bg->prev)
+            bg->prev->next = bg->next;
+        else
+            ct->big = bg->next;
+        if (bg->next)
+            bg->next->prev = bg->prev;
+        heap_free(dcast(&bg, byte_t), (uint32_t)(sizeof(big) + bl->size), ct->name);
+    }
+    else
+    {
+        slab *sl = bl->owner;
+        uint32_t n = i_carved(bl->size);
+        sl->live -= n;
+        if (sl == ct->cur)
+        {
+            /* the last block carved is taken back */
+            if (sl->live == 0)
+                sl->used = 0;
+            else if (cast(bl, byte_t) + n == i_data(sl) + sl->used)
+                sl->used -= n;
+        }
+        else if (sl->live == 0)
+        {
+            i_unlink(ct, sl);
+            i_empty(ct, sl);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void *i_realloc(context *ct, void *ptr, size_t old_size, size_t size)
+{
+    block *bl = cast(ptr, block) - 1;
+    void *newptr;
+    if (bl->owner == NULL && size > ALC_BIG)
+    {
+        big *bg = cast(cast(bl, byte_t) - (sizeof(big) - sizeof(block)), big);
+        i_resize(ct, bl->size, size);
+        bg = cast(heap_realloc(cast(bg, byte_t), (uint32_t)(sizeof(big) + bl->size), (uint32_t)(sizeof(big) + size), ct->name), big);
+        if (bg->prev)
+            bg->prev->next = bg;
+        else
+            ct->big = bg;
+        if (bg->next)
+            bg->next->prev = bg;
+        bg->head.size = size;
+        return &bg->head + 1;
+    }
+
+    if (bl->owner != NULL && bl->owner == ct->cur && size <= ALC_BIG)
+    {
+        /* the last block carved grows or shrinks in place */
+        slab *sl = bl->owner;
+        uint32_t n = i_carved(bl->size), m = i_carved(size);
+        if (cast(bl, byte_t) + n == i_data(sl) + sl->used && sl->used - n + m <= SLAB_DATA)
+        {
+            i_resize(ct, bl->size, size);
+            sl->used = sl->used - n + m;
+            sl->live = sl->live - n + m;
+            bl->size = size;
+            return ptr;
+        }
+    }
+
+    newptr = i_malloc(ct, size);
+    bmem_copy(cast(newptr, byte_t), cast(ptr, byte_t), (uint32_t)(old_size < size ? old_size : size));
+    i_free(ct, ptr);
     return newptr;
 }
 
-static void sdk_free(void *ctx, void *ptr)
+/*---------------------------------------------------------------------------*/
+
+static void *sdk_malloc(void *ctx, size_t size)
+{
+    context *ct = cast(ctx, context);
+    void *ptr;
+    bmutex_lock(ct->mutex);
+    ptr = i_malloc(ct, size);
+    bmutex_unlock(ct->mutex);
+    return ptr;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void *sdk_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
 {
     context *ct = cast(ctx, context);
-    addr *val, key;
-    key.ptr = ptr;
-    val = setst_get(ct->set, &key, addr, addr);
-    cassert_no_null(val);
-    heap_free(dcast(&ptr, byte_t), val->size, ct->name);
-    setst_delete(ct->set, &key, NULL, addr, addr);
+    void *newptr;
+    bmutex_lock(ct->mutex);
+    newptr = i_realloc(ct, ptr, old_size, size);
+    bmutex_unlock(ct->mutex);
+    return newptr;
 }
 
-static int addr_cmp(const addr *a, const addr *b)
+/*---------------------------------------------------------------------------*/
+
+static void sdk_free(void *ctx, void *ptr)
 {
-    if (a->ptr < b->ptr)
-        return -1;
-    else if (a->ptr > b->ptr)
-        return 1;
-    else
-        return 0;
+    context *ct = cast(ctx, context);
+    bmutex_lock(ct->mutex);
+    i_free(ct, ptr);
+    bmutex_unlock(ct->mutex);
 }
 
-yyjson_alc *alc_init(const char_t *name)
+/*---------------------------------------------------------------------------*/
+
+yyjson_alc *alc_init(const char_t *name, const mem_t mem)
 {
-    context *ct = heap_new(context);
+    context *ct = heap_new0(context);
     struct yyjson_alc *alc = heap_new(yyjson_alc);
     alc->malloc = sdk_malloc;
     alc->realloc = sdk_realloc;
     alc->free = sdk_free;
 
     str_copy_c(ct->name, MAX_NAME_LEN, name);
-    ct->set = setst_create(addr_cmp, addr, addr);
+    ct->mem = mem;
+    ct->mutex = bmutex_create();
     alc->ctx = ct;
     return alc;
 }
 
+/*---------------------------------------------------------------------------*/
+
+/* frees every block at once, no doc of the allocator can be in use */
+void alc_reset(yyjson_alc *alc)
+{
+    context *ct = cast(alc->ctx, context);
+    bmutex_lock(ct->mutex);
+    audit_free(ct->mem, ct->live);
+    ct->live = 0;
+    while (ct->big)
+    {
+        big *bg = ct->big;
+        ct->big = bg->next;
+        heap_free(dcast(&bg, byte_t), (uint32_t)(sizeof(big) + bg->head.size), ct->name);
+    }
+
+    while (ct->full)
+    {
+        slab *sl = ct->full;
+        ct->full = sl->next;
+        i_slab_free(ct, sl);
+    }
+
+    if (ct->cur)
+    {
+        i_empty(ct, ct->cur);
+        ct->cur = NULL;
+    }
+
+    bmutex_unlock(ct->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
 void alc_dest(yyjson_alc **alc)
 {
     context *ct = cast((*alc)->ctx, context);
-    setst_destroy(&ct->set, NULL, addr);
+    alc_reset(*alc);
+    if (ct->spare)
+        i_slab_free(ct, ct->spare);
+    bmutex_close(&ct->mutex);
     heap_delete(&ct, context);
     heap_delete(alc, yyjson_alc);
 }
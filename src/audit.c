@@ -0,0 +1,113 @@
+/*
+ memory audit of what kutes allocates on its own: yyjson docs, the boron
+ heap and the text the output views hold. every thread counts into a slot
+ picked once per thread and a read adds the slots up, so the allocation path
+ never touches a line another thread writes. updates are relaxed atomics,
+ threads past AUDIT_SLOTS share slots and the counts stay exact. peak is the
+ highest live total a sample or a read has seen, the gui samples often enough.
+*/
+#include "kt.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define i_add(ptr, val) __atomic_fetch_add(ptr, val, __ATOMIC_RELAXED)
+#define i_load(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define i_cas(ptr, expected, val) __atomic_compare_exchange_n(ptr, expected, val, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define i_thread __thread
+#else
+#error "atomics are only wired for gcc/clang"
+#endif
+
+#define AUDIT_SLOTS 16
+/* keeps the counters of two slots on different cache lines */
+#define CACHE_LINE 64
+
+typedef struct _slot_t Slot;
+struct _slot_t
+{
+    /* a block can be freed on another thread than the one that took it */
+    int64_t live[ktMEM_COUNT];
+    uint64_t allocs[ktMEM_COUNT];
+    byte_t pad[CACHE_LINE];
+};
+
+static Slot i_slots[AUDIT_SLOTS];
+static uint32_t i_next_slot;
+static uint64_t i_peak[ktMEM_COUNT];
+static i_thread Slot *i_slot;
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE Slot *i_own(void)
+{
+    if (i_slot == NULL)
+        i_slot = i_slots + i_add(&i_next_slot, 1) % AUDIT_SLOTS;
+    return i_slot;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void audit_alloc(const mem_t mem, const size_t size)
+{
+    Slot *slot = i_own();
+    i_add(&slot->live[mem], (int64_t)size);
+    i_add(&slot->allocs[mem], 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void audit_free(const mem_t mem, const size_t size)
+{
+    i_add(&i_own()->live[mem], -(int64_t)size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* live total of mem, slots read one after another can be a moment apart */
+static uint64_t i_live(const mem_t mem, uint64_t *allocs)
+{
+    int64_t live = 0;
+    uint32_t i;
+    for (i = 0; i < AUDIT_SLOTS; ++i)
+    {
+        live += i_load(&i_slots[i].live[mem]);
+        if (allocs != NULL)
+            *allocs += i_load(&i_slots[i].allocs[mem]);
+    }
+    return live > 0 ? (uint64_t)live : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* peak of mem once live is accounted */
+static uint64_t i_raise(const mem_t mem, const uint64_t live)
+{
+    uint64_t peak = i_load(&i_peak[mem]);
+    while (live > peak && !i_cas(&i_peak[mem], &peak, live))
+    {
+    }
+    return peak > live ? peak : live;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* raises the peaks to the live totals, callable from any thread */
+void audit_sample(void)
+{
+    uint32_t m;
+    for (m = 0; m < ktMEM_COUNT; ++m)
+        i_raise((mem_t)m, i_live((mem_t)m, NULL));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* ktMEM_COUNT stats, callable from any thread */
+void audit_read(MemStat *stats)
+{
+    uint32_t m;
+    for (m = 0; m < ktMEM_COUNT; ++m)
+    {
+        stats[m].allocs = 0;
+        stats[m].live = i_live((mem_t)m, &stats[m].allocs);
+        stats[m].peak = i_raise((mem_t)m, stats[m].live);
+    }
+}
@@ -6,6 +6,8 @@ const char_t *st_running = "⏳running";     /* U+23f3 */
 const char_t *st_stopping = "⌛stopping";   /* U+231b */
 const char_t *st_stopped = "✕ stopped";     /* U+2715 */
 const char_t *st_completed = "✓ completed"; /* U+2713 */
+const char_t *st_parsing = "⏳parsing";     /* U+23f3 */
 const char_t *st_unknown = "? unknown";
+const char_t *st_exited = "✕ exited";     /* U+2715 */
 const char_t *bt_run = "&run";
 const char_t *bt_stop = "&stop";
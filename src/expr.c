@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <unset.h>
 
+#include <stdlib.h>
 #include <time.h>
 
 static UAtom jrootW;
@@ -459,3 +460,46 @@ yyjson_mut_val *bn_jval(UThread *ut, UCell *val)
         return ser->ptr.v;
     return NULL;
 }
+
+/*
+ heap of boron, built with CONFIG_MEM_HOOK. every block keeps its size in a
+ header of its own alignment so a free can be audited
+*/
+#define BN_HEAD 16
+
+void *memAlloc(size_t size)
+{
+    byte_t *ptr = cast(malloc(BN_HEAD + size), byte_t);
+    if (ptr == NULL)
+        return NULL;
+    *cast(ptr, size_t) = size;
+    audit_alloc(ktMEM_BORON, size);
+    return ptr + BN_HEAD;
+}
+
+void *memRealloc(void *mem, size_t size)
+{
+    byte_t *ptr;
+    size_t old_size;
+    if (mem == NULL)
+        return memAlloc(size);
+    ptr = cast(mem, byte_t) - BN_HEAD;
+    old_size = *cast(ptr, size_t);
+    ptr = cast(realloc(ptr, BN_HEAD + size), byte_t);
+    if (ptr == NULL)
+        return NULL;
+    *cast(ptr, size_t) = size;
+    audit_free(ktMEM_BORON, old_size);
+    audit_alloc(ktMEM_BORON, size);
+    return ptr + BN_HEAD;
+}
+
+void memFree(void *mem)
+{
+    byte_t *ptr;
+    if (mem == NULL)
+        return;
+    ptr = cast(mem, byte_t) - BN_HEAD;
+    audit_free(ktMEM_BORON, *cast(ptr, size_t));
+    free(ptr);
+}
@@ -0,0 +1,80 @@
+/*
+ substring search over kutes' own output buffers. with sse2 the candidates
+ are filtered 16 positions at a time on the first and the last byte of the
+ pattern and only positions where both match are compared in full. the tail,
+ or everything without sse2, is walked with memchr on the first byte.
+*/
+#include "kt.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIND_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(FIND_SSE2)
+static ___INLINE uint32_t i_lowest_bit(const uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (uint32_t)bit;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* offset of the first occurrence of pattern in text, UINT32_MAX if none */
+uint32_t find_bytes(const byte_t *text, const uint32_t len, const byte_t *pattern, const uint32_t plen)
+{
+    uint32_t i = 0;
+    if (plen == 0 || plen > len)
+        return UINT32_MAX;
+
+    if (plen == 1)
+    {
+        const byte_t *p = cast_const(memchr(text, pattern[0], len), byte_t);
+        return p ? (uint32_t)(p - text) : UINT32_MAX;
+    }
+
+#if defined(FIND_SSE2)
+    {
+        const __m128i first = _mm_set1_epi8((char)pattern[0]);
+        const __m128i last = _mm_set1_epi8((char)pattern[plen - 1]);
+        for (; i + plen - 1 + 16 <= len; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(text + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(text + i + plen - 1));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+            while (mask != 0)
+            {
+                uint32_t bit = i_lowest_bit(mask);
+                if (plen == 2 || bmem_cmp(text + i + bit + 1, pattern + 1, plen - 2) == 0)
+                    return i + bit;
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    while (i + plen <= len)
+    {
+        const byte_t *p = cast_const(memchr(text + i, pattern[0], len - plen + 1 - i), byte_t);
+        if (p == NULL)
+            return UINT32_MAX;
+        i = (uint32_t)(p - text);
+        if (text[i + plen - 1] == pattern[plen - 1] && (plen == 2 || bmem_cmp(text + i + 1, pattern + 1, plen - 2) == 0))
+            return i;
+        i++;
+    }
+
+    return UINT32_MAX;
+}
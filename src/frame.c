@@ -0,0 +1,119 @@
+/*
+ splits output chunks into lines. a line is handed out in place as a span of
+ the chunk being framed, only a line that crosses chunks is assembled in the
+ carry buffer. newlines are found with memchr, vectorized by the libcs kutes
+ builds with. every line is followed by its newline in memory so a consumer
+ can take it with or without it.
+*/
+#include "kt.h"
+#include <string.h>
+
+#define FRAME_CARRY 256
+
+struct _framer_t
+{
+    const byte_t *data;
+    uint32_t size;
+    uint32_t pos;
+    byte_t *carry;
+    uint32_t carry_len;
+    uint32_t carry_size;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static void i_carry(Framer *framer, const byte_t *data, const uint32_t len)
+{
+    if (framer->carry_len + len > framer->carry_size)
+    {
+        uint32_t size = framer->carry_size;
+        while (framer->carry_len + len > size)
+            size *= 2;
+        framer->carry = heap_realloc_n(framer->carry, framer->carry_size, size, byte_t);
+        framer->carry_size = size;
+    }
+
+    bmem_copy(framer->carry + framer->carry_len, data, len);
+    framer->carry_len += len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Framer *framer_create(void)
+{
+    Framer *framer = heap_new0(Framer);
+    framer->carry_size = FRAME_CARRY;
+    framer->carry = heap_new_n(framer->carry_size, byte_t);
+    return framer;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void framer_destroy(Framer **framer)
+{
+    heap_delete_n(&(*framer)->carry, (*framer)->carry_size, byte_t);
+    heap_delete(framer, Framer);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* drops a partial line, the next chunk starts a new one */
+void framer_reset(Framer *framer)
+{
+    framer->data = NULL;
+    framer->size = 0;
+    framer->pos = 0;
+    framer->carry_len = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* data has to stay until framer_next returns FALSE */
+void framer_feed(Framer *framer, const byte_t *data, const uint32_t size)
+{
+    cassert(framer->pos == framer->size);
+    framer->data = data;
+    framer->size = size;
+    framer->pos = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ next complete line without its newline, valid until the next call. FALSE
+ once the chunk is used up, its unterminated tail waits for the next one
+*/
+bool_t framer_next(Framer *framer, const byte_t **line, uint32_t *len)
+{
+    const byte_t *st = framer->data + framer->pos;
+    const byte_t *nl = NULL;
+    uint32_t n = 0;
+    if (framer->pos == framer->size)
+        return FALSE;
+
+    nl = cast_const(memchr(st, '\n', framer->size - framer->pos), byte_t);
+    if (nl == NULL)
+    {
+        i_carry(framer, st, framer->size - framer->pos);
+        framer->pos = framer->size;
+        return FALSE;
+    }
+
+    n = (uint32_t)(nl - st);
+    framer->pos += n + 1;
+    if (framer->carry_len > 0)
+    {
+        /* buffer stays as is until the next carry */
+        i_carry(framer, st, n + 1);
+        *line = framer->carry;
+        *len = framer->carry_len - 1;
+        framer->carry_len = 0;
+    }
+    else
+    {
+        *line = st;
+        *len = n;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,648 @@
+/*
+ in-process client for the kubernetes api, a Run that starts with '/' is a
+ raw api path (like kubectl get --raw) and its response body is streamed to
+ the reader as stdout without a process or a pipe in between. server comes
+ from KUTES_APISERVER or the current context of the kubeconfig. there is no
+ tls, so it is meant to be used with 'kubectl proxy' or a plain http server.
+*/
+#include "kt.h"
+
+#include <inet/url.h>
+#include <stdlib.h>
+
+/* reads only pick up what already arrived, waiting is done in kapi_poll */
+#define KAPI_READ_TIMEOUT 1
+#define KAPI_CONNECT_TIMEOUT 5000
+/* status line and headers have to fit in here */
+#define KAPI_BUFFER (16 * 1024)
+
+typedef enum _kapi_state_t
+{
+    ekKAPI_HEADERS,
+    ekKAPI_LENGTH,
+    ekKAPI_CLOSE,
+    ekKAPI_CHUNK_SIZE,
+    ekKAPI_CHUNK_DATA,
+    ekKAPI_CHUNK_END,
+    ekKAPI_DONE
+} kapi_state_t;
+
+struct _kapi_t
+{
+    Socket *sock;
+    String *error;
+    uint32_t error_pos;
+    byte_t *buf;
+    uint32_t pos;
+    uint32_t len;
+    uint64_t remain;
+    uint32_t status;
+    kapi_state_t state;
+    bool_t failed;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_is_space(const char_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r' ? TRUE : FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_prefix_nocase(const char_t *str, const uint32_t len, const char_t *prefix)
+{
+    uint32_t i, plen = str_len_c(prefix);
+    if (len < plen)
+        return FALSE;
+    for (i = 0; i < plen; ++i)
+    {
+        char_t c = str[i];
+        if (c >= 'A' && c <= 'Z')
+            c = (char_t)(c - 'A' + 'a');
+        if (c != prefix[i])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* value of a "key: value" line, without quotes, NULL if the line has another key */
+static const char_t *i_yaml_value(const char_t *line, const char_t *end, const char_t *key, uint32_t *len)
+{
+    uint32_t klen = str_len_c(key);
+    const char_t *value = line + klen + 1;
+    if ((uint32_t)(end - line) < klen + 1 || !str_equ_cn(line, key, klen) || line[klen] != ':')
+        return NULL;
+
+    while (value < end && i_is_space(*value))
+        value++;
+    while (end > value && i_is_space(end[-1]))
+        end--;
+    if (end - value >= 2 && (*value == '"' || *value == '\'') && end[-1] == *value)
+    {
+        value++;
+        end--;
+    }
+    *len = (uint32_t)(end - value);
+    return value;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ just enough yaml for kubeconfig files as kubectl writes them: top level keys,
+ sections holding lists of mappings and the leaf "key: value" of an item.
+ with a NULL section the top level key is looked up, otherwise the key of the
+ item in section whose name is name.
+*/
+static String *i_yaml_get(const char_t *yaml, const char_t *section, const char_t *name, const char_t *key)
+{
+    const char_t *line = yaml;
+    const char_t *item_name = NULL, *item_value = NULL;
+    uint32_t name_len = 0, value_len = 0;
+    bool_t in_section = FALSE;
+    while (*line)
+    {
+        const char_t *end = line, *content = line;
+        uint32_t indent;
+        bool_t item = FALSE;
+        while (*end && *end != '\n')
+            end++;
+        while (content < end && *content == ' ')
+            content++;
+        indent = (uint32_t)(content - line);
+        if (content < end && content[0] == '-' && content + 1 < end && content[1] == ' ')
+        {
+            item = TRUE;
+            content += 2;
+            while (content < end && *content == ' ')
+                content++;
+        }
+
+        if (content < end && *content != '#')
+        {
+            const char_t *value;
+            uint32_t len;
+            /* an item ends with the next one or with the section */
+            if (in_section && (item || (indent == 0 && !item)))
+            {
+                if (item_name && item_value && name_len == str_len_c(name) && str_equ_cn(item_name, name, name_len))
+                    return str_cn(item_value, value_len);
+                item_name = item_value = NULL;
+            }
+
+            if (indent == 0 && !item)
+            {
+                if (section == NULL)
+                {
+                    value = i_yaml_value(content, end, key, &len);
+                    if (value)
+                        return str_cn(value, len);
+                }
+                else
+                {
+                    in_section = i_yaml_value(content, end, section, &len) != NULL;
+                }
+            }
+            else if (in_section)
+            {
+                if ((value = i_yaml_value(content, end, "name", &len)) != NULL)
+                {
+                    item_name = value;
+                    name_len = len;
+                }
+                else if ((value = i_yaml_value(content, end, key, &len)) != NULL && len > 0)
+                {
+                    item_value = value;
+                    value_len = len;
+                }
+            }
+        }
+        line = *end ? end + 1 : end;
+    }
+
+    if (in_section && item_name && item_value && name_len == str_len_c(name) && str_equ_cn(item_name, name, name_len))
+        return str_cn(item_value, value_len);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static String *i_kubeconfig_path(void)
+{
+    const char_t *env = blib_getenv("KUBECONFIG");
+    if (env && env[0])
+    {
+        /* only the first file of the list */
+#if defined(__WINDOWS__)
+        const char_t *sep = str_str(env, ";");
+#else
+        const char_t *sep = str_str(env, ":");
+#endif
+        return sep ? str_cn(env, (uint32_t)(sep - env)) : str_c(env);
+    }
+    return hfile_home_dir(".kube/config");
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* server url and token of the current context, error describes what's missing */
+static bool_t i_endpoint(String **server, String **token, String **error)
+{
+    const char_t *env = blib_getenv("KUTES_APISERVER");
+    String *path, *yaml, *ctx = NULL, *cluster = NULL, *user = NULL;
+    if (env && env[0])
+    {
+        const char_t *tenv = blib_getenv("KUTES_TOKEN");
+        *server = str_c(env);
+        *token = tenv && tenv[0] ? str_c(tenv) : NULL;
+        return TRUE;
+    }
+
+    path = i_kubeconfig_path();
+    yaml = hfile_string(tc(path), NULL);
+    if (yaml)
+    {
+        ctx = i_yaml_get(tc(yaml), NULL, NULL, "current-context");
+        if (ctx)
+        {
+            cluster = i_yaml_get(tc(yaml), "contexts", tc(ctx), "cluster");
+            user = i_yaml_get(tc(yaml), "contexts", tc(ctx), "user");
+        }
+        if (cluster)
+            *server = i_yaml_get(tc(yaml), "clusters", tc(cluster), "server");
+        if (user)
+            *token = i_yaml_get(tc(yaml), "users", tc(user), "token");
+    }
+
+    if (*server == NULL)
+        *error = str_printf("no api server found in '%s', set KUTES_APISERVER (ex: http://127.0.0.1:8001 of 'kubectl proxy')\n", tc(path));
+
+    str_destopt(&ctx);
+    str_destopt(&cluster);
+    str_destopt(&user);
+    str_destopt(&yaml);
+    str_destroy(&path);
+    return *server != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_write(Socket *sock, const char_t *data)
+{
+    return bsocket_write(sock, cast_const(data, byte_t), str_len_c(data), NULL, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Socket *i_connect(const String *server, const String *token, const char_t *path, String **error)
+{
+    Url *url = url_parse(tc(server));
+    Socket *sock = NULL;
+    const char_t *scheme = url ? url_scheme(url) : NULL;
+    if (url == NULL || url_host(url) == NULL)
+    {
+        *error = str_printf("invalid api server url '%s'\n", tc(server));
+    }
+    else if (!str_equ_c(scheme, "http"))
+    {
+        *error = str_printf("'%s' needs tls which isn't supported, run 'kubectl proxy' and set KUTES_APISERVER to its address\n", tc(server));
+    }
+    else
+    {
+        uint16_t port = url_port(url) != UINT16_MAX ? url_port(url) : 80;
+        uint32_t ip = bsocket_url_ip(url_host(url), NULL);
+        sock = ip ? bsocket_connect(ip, port, KAPI_CONNECT_TIMEOUT, NULL) : NULL;
+        if (sock)
+        {
+            String *req = str_printf("GET %s HTTP/1.1\r\nHost: %s:%d\r\nUser-Agent: kutes\r\nAccept: application/json\r\nConnection: close\r\n", path, url_host(url), port);
+            bool_t ok;
+            if (token)
+            {
+                str_cat(&req, "Authorization: Bearer ");
+                str_cat(&req, tc(token));
+                str_cat(&req, "\r\n");
+            }
+            str_cat(&req, "\r\n");
+            ok = i_write(sock, tc(req));
+            str_destroy(&req);
+            if (!ok)
+                bsocket_close(&sock);
+        }
+
+        if (sock)
+            bsocket_read_timeout(sock, KAPI_READ_TIMEOUT);
+        else
+            *error = str_printf("can't connect to '%s'\n", tc(server));
+    }
+
+    if (url)
+        url_destroy(&url);
+    return sock;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* appends to buf whatever the socket has, ekPAGAIN when nothing arrived in time */
+static bool_t i_fill(Kapi *api, perror_t *error)
+{
+    uint32_t rsize = 0;
+    serror_t serr;
+    if (api->pos > 0)
+    {
+        bmem_move(api->buf, api->buf + api->pos, api->len - api->pos);
+        api->len -= api->pos;
+        api->pos = 0;
+    }
+
+    if (api->len == KAPI_BUFFER)
+    {
+        /* headers too large */
+        api->failed = TRUE;
+        api->state = ekKAPI_DONE;
+        ptr_assign(error, ekPPIPE);
+        return FALSE;
+    }
+
+    if (bsocket_recv(api->sock, api->buf + api->len, KAPI_BUFFER - api->len, &rsize, &serr))
+    {
+        api->len += rsize;
+        return TRUE;
+    }
+
+    if (serr == ekSTIMEOUT)
+    {
+        ptr_assign(error, ekPAGAIN);
+    }
+    else
+    {
+        /* closed or broken, the body ends here */
+        if (api->state != ekKAPI_CLOSE)
+            api->failed = TRUE;
+        api->state = ekKAPI_DONE;
+        ptr_assign(error, ekPOK);
+    }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* position of the next crlf in buf or UINT32_MAX */
+static uint32_t i_crlf(const Kapi *api, const uint32_t from)
+{
+    uint32_t i;
+    for (i = from; i + 1 < api->len; ++i)
+    {
+        if (api->buf[i] == '\r' && api->buf[i + 1] == '\n')
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_headers(Kapi *api, const uint32_t end)
+{
+    const char_t *line = cast_const(api->buf, char_t);
+    uint32_t i = i_crlf(api, 0);
+    bool_t chunked = FALSE, length = FALSE;
+    /* HTTP/1.1 200 OK */
+    const char_t *space = str_str(line, " ");
+    if (space && space < line + i)
+        api->status = (uint32_t)atoi(space + 1);
+
+    while (i < end)
+    {
+        uint32_t next = i_crlf(api, i + 2);
+        const char_t *hdr = line + i + 2;
+        uint32_t hlen = next - i - 2;
+        const char_t *value = str_str(hdr, "chunked");
+        if (i_prefix_nocase(hdr, hlen, "transfer-encoding:") && value && value < hdr + hlen)
+        {
+            chunked = TRUE;
+        }
+        else if (i_prefix_nocase(hdr, hlen, "content-length:"))
+        {
+            api->remain = (uint64_t)atoll(hdr + 15);
+            length = TRUE;
+        }
+        i = next;
+    }
+
+    api->pos = end + 4;
+    if (chunked)
+        api->state = ekKAPI_CHUNK_SIZE;
+    else if (length)
+        api->state = ekKAPI_LENGTH;
+    else
+        api->state = ekKAPI_CLOSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* position of the empty line that ends the headers or UINT32_MAX */
+static uint32_t i_headers_end(const Kapi *api)
+{
+    uint32_t i;
+    for (i = 0; i + 3 < api->len; ++i)
+    {
+        if (bmem_cmp(api->buf + i, cast_const("\r\n\r\n", byte_t), 4) == 0)
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_response(Kapi *api, perror_t *error)
+{
+    while (api->state == ekKAPI_HEADERS)
+    {
+        uint32_t i = i_headers_end(api);
+        if (i != UINT32_MAX)
+        {
+            api->buf[i + 2] = '\0';
+            i_headers(api, i);
+        }
+        else if (!i_fill(api, error))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* decoded body, chunked transfer encoding is undone here */
+static bool_t i_body(Kapi *api, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    ptr_assign(rsize, 0);
+    ptr_assign(error, ekPOK);
+    if (!i_response(api, error))
+        return FALSE;
+
+    while (api->state != ekKAPI_DONE)
+    {
+        if (api->state == ekKAPI_CHUNK_SIZE || api->state == ekKAPI_CHUNK_END)
+        {
+            uint32_t end = i_crlf(api, api->pos);
+            if (end == UINT32_MAX)
+            {
+                if (!i_fill(api, error))
+                    return FALSE;
+                continue;
+            }
+
+            if (api->state == ekKAPI_CHUNK_SIZE)
+            {
+                api->buf[end] = '\0';
+                api->remain = (uint64_t)strtoull(cast(api->buf + api->pos, char_t), NULL, 16);
+                /* trailers after the last chunk aren't of interest */
+                api->state = api->remain ? ekKAPI_CHUNK_DATA : ekKAPI_DONE;
+            }
+            else
+            {
+                api->state = ekKAPI_CHUNK_SIZE;
+            }
+            api->pos = end + 2;
+        }
+        else if (api->state == ekKAPI_LENGTH && api->remain == 0)
+        {
+            api->state = ekKAPI_DONE;
+        }
+        else if (api->pos < api->len)
+        {
+            uint32_t n = min_u32(size, api->len - api->pos);
+            if (api->state != ekKAPI_CLOSE && api->remain < n)
+                n = (uint32_t)api->remain;
+            bmem_copy(data, api->buf + api->pos, n);
+            api->pos += n;
+            if (api->state != ekKAPI_CLOSE)
+                api->remain -= n;
+            if (api->state == ekKAPI_CHUNK_DATA && api->remain == 0)
+                api->state = ekKAPI_CHUNK_END;
+            ptr_assign(rsize, n);
+            return TRUE;
+        }
+        else if (!i_fill(api, error))
+        {
+            return FALSE;
+        }
+    }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* connection problems are reported on the error stream, never NULL */
+Kapi *kapi_open(const char_t *path)
+{
+    Kapi *api = heap_new0(Kapi);
+    String *server = NULL, *token = NULL;
+    if (i_endpoint(&server, &token, &api->error))
+        api->sock = i_connect(server, token, path, &api->error);
+
+    if (api->sock)
+    {
+        api->buf = heap_new_n(KAPI_BUFFER, byte_t);
+    }
+    else
+    {
+        api->state = ekKAPI_DONE;
+        api->failed = TRUE;
+    }
+
+    str_destopt(&server);
+    str_destopt(&token);
+    return api;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void kapi_close(Kapi **api)
+{
+    cassert_no_null(api);
+    cassert_no_null(*api);
+    if ((*api)->sock)
+        bsocket_close(&(*api)->sock);
+    if ((*api)->buf)
+        heap_delete_n(&(*api)->buf, KAPI_BUFFER, byte_t);
+    str_destopt(&(*api)->error);
+    heap_delete(api, Kapi);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* TRUE when buf holds enough for a read to move on, a partial header block or chunk size line isn't */
+static bool_t i_buffered(const Kapi *api)
+{
+    switch (api->state)
+    {
+    case ekKAPI_HEADERS:
+        return i_headers_end(api) != UINT32_MAX;
+    case ekKAPI_CHUNK_SIZE:
+    case ekKAPI_CHUNK_END:
+        return i_crlf(api, api->pos) != UINT32_MAX;
+    case ekKAPI_LENGTH:
+        return api->remain == 0 || api->pos < api->len;
+    case ekKAPI_CLOSE:
+    case ekKAPI_CHUNK_DATA:
+        return api->pos < api->len;
+    case ekKAPI_DONE:
+        return TRUE;
+    cassert_default();
+    }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* waits for data like polling a pipe, TRUE when a read can make progress or the response ended */
+bool_t kapi_poll(Kapi *api, const uint32_t timeout_ms)
+{
+    bool_t ready;
+    cassert_no_null(api);
+    if (i_buffered(api))
+        return TRUE;
+
+    bsocket_read_timeout(api->sock, timeout_ms);
+    ready = i_fill(api, NULL) || api->state == ekKAPI_DONE;
+    bsocket_read_timeout(api->sock, KAPI_READ_TIMEOUT);
+    return ready;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* body of a successful response, returns ekPAGAIN as soon as the socket has nothing */
+bool_t kapi_read(Kapi *api, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    cassert_no_null(api);
+    if (api->sock && !i_response(api, error))
+    {
+        ptr_assign(rsize, 0);
+        return FALSE;
+    }
+
+    if (api->status >= 200 && api->status < 300)
+        return i_body(api, data, size, rsize, error);
+
+    ptr_assign(rsize, 0);
+    ptr_assign(error, ekPOK);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* connection errors and the body (a Status object) of a failed response */
+bool_t kapi_eread(Kapi *api, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    cassert_no_null(api);
+    if (api->error && api->error_pos < str_len(api->error))
+    {
+        uint32_t n = min_u32(size, str_len(api->error) - api->error_pos);
+        bmem_copy(data, cast_const(tc(api->error), byte_t) + api->error_pos, n);
+        api->error_pos += n;
+        ptr_assign(rsize, n);
+        ptr_assign(error, ekPOK);
+        return TRUE;
+    }
+
+    if (api->sock && api->state == ekKAPI_HEADERS)
+    {
+        ptr_assign(rsize, 0);
+        ptr_assign(error, ekPAGAIN);
+        return FALSE;
+    }
+
+    if (api->sock && (api->status < 200 || api->status >= 300))
+        return i_body(api, data, size, rsize, error);
+
+    ptr_assign(rsize, 0);
+    ptr_assign(error, ekPOK);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* exit code like a command, 0 only for a complete successful response */
+bool_t kapi_finish(const Kapi *api, uint32_t *code)
+{
+    cassert_no_null(api);
+    if (api->state != ekKAPI_DONE)
+        return FALSE;
+    ptr_assign(code, !api->failed && api->status >= 200 && api->status < 300 ? 0 : 1);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* raw list with a page size, the pages after the first one are fetched with continue */
+bool_t kapi_paged(const char_t *command)
+{
+    return command[0] == '/' && str_str(command, "limit=") != NULL && str_str(command, "continue=") == NULL && str_str(command, "watch=") == NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* path of the page after the one that returned token, the token is opaque (base64) */
+String *kapi_page(const char_t *path, const char_t *token)
+{
+    static const char_t *hex = "0123456789ABCDEF";
+    Stream *stm = stm_memory(256);
+    String *page;
+    stm_printf(stm, "%s&continue=", path);
+    for (; *token != '\0'; ++token)
+    {
+        char_t c = *token;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~')
+            stm_write_char(stm, (uint32_t)c);
+        else
+            stm_printf(stm, "%%%c%c", hex[(byte_t)c >> 4], hex[(byte_t)c & 0xF]);
+    }
+    page = stm_str(stm);
+    stm_close(&stm);
+    return page;
+}
@@ -0,0 +1,150 @@
+/*
+ key to line number map for replace mode. open addressing with linear
+ probing over a power of two table kept at most half full. keys are stored
+ back to back in one buffer so a line can be keyed on a field of any length.
+*/
+#include "kt.h"
+
+#define KEYMAP_SLOTS 1024
+#define KEYMAP_BYTES (16 * 1024)
+
+typedef struct _kslot_t Kslot;
+struct _kslot_t
+{
+    uint32_t hash;
+    uint32_t key;
+    uint32_t len;
+    /* UINT32_MAX for a free slot */
+    uint32_t value;
+};
+
+struct _keymap_t
+{
+    Kslot *slots;
+    uint32_t nslots;
+    uint32_t count;
+    byte_t *keys;
+    uint32_t keys_len;
+    uint32_t keys_size;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* fnv-1a */
+static uint32_t i_hash(const byte_t *key, const uint32_t len)
+{
+    uint32_t hash = 2166136261u, i;
+    for (i = 0; i < len; ++i)
+    {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Kslot *i_slots(const uint32_t nslots)
+{
+    Kslot *slots = heap_new_n(nslots, Kslot);
+    uint32_t i;
+    for (i = 0; i < nslots; ++i)
+        slots[i].value = UINT32_MAX;
+    return slots;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_grow(Keymap *map)
+{
+    uint32_t i, nslots = map->nslots * 2;
+    Kslot *slots = i_slots(nslots);
+    for (i = 0; i < map->nslots; ++i)
+    {
+        if (map->slots[i].value != UINT32_MAX)
+        {
+            uint32_t j = map->slots[i].hash & (nslots - 1);
+            while (slots[j].value != UINT32_MAX)
+                j = (j + 1) & (nslots - 1);
+            slots[j] = map->slots[i];
+        }
+    }
+    heap_delete_n(&map->slots, map->nslots, Kslot);
+    map->slots = slots;
+    map->nslots = nslots;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Keymap *keymap_create(void)
+{
+    Keymap *map = heap_new0(Keymap);
+    map->nslots = KEYMAP_SLOTS;
+    map->slots = i_slots(map->nslots);
+    map->keys_size = KEYMAP_BYTES;
+    map->keys = heap_new_n(map->keys_size, byte_t);
+    return map;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void keymap_destroy(Keymap **map)
+{
+    heap_delete_n(&(*map)->slots, (*map)->nslots, Kslot);
+    heap_delete_n(&(*map)->keys, (*map)->keys_size, byte_t);
+    heap_delete(map, Keymap);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* drops every key, the table and buffer keep their size */
+void keymap_clear(Keymap *map)
+{
+    uint32_t i;
+    for (i = 0; i < map->nslots; ++i)
+        map->slots[i].value = UINT32_MAX;
+    map->count = 0;
+    map->keys_len = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* TRUE if key is new and takes *value, otherwise *value gets the one it has */
+bool_t keymap_insert(Keymap *map, const byte_t *key, const uint32_t len, uint32_t *value)
+{
+    uint32_t hash = i_hash(key, len);
+    uint32_t i = hash & (map->nslots - 1);
+    Kslot *slot = NULL;
+    cassert(*value != UINT32_MAX);
+    while (map->slots[i].value != UINT32_MAX)
+    {
+        slot = map->slots + i;
+        if (slot->hash == hash && slot->len == len && bmem_cmp(map->keys + slot->key, key, len) == 0)
+        {
+            *value = slot->value;
+            return FALSE;
+        }
+        i = (i + 1) & (map->nslots - 1);
+    }
+
+    if (map->keys_len + len > map->keys_size)
+    {
+        uint32_t size = map->keys_size;
+        while (map->keys_len + len > size)
+            size *= 2;
+        map->keys = heap_realloc_n(map->keys, map->keys_size, size, byte_t);
+        map->keys_size = size;
+    }
+
+    slot = map->slots + i;
+    slot->hash = hash;
+    slot->key = map->keys_len;
+    slot->len = len;
+    slot->value = *value;
+    bmem_copy(map->keys + map->keys_len, key, len);
+    map->keys_len += len;
+    map->count += 1;
+    if (map->count * 2 > map->nslots)
+        i_grow(map);
+    return TRUE;
+}
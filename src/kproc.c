@@ -0,0 +1,620 @@
+/*
+ runs commands for the output panes. on unix a single bash is kept alive for
+ the session (grown out of support/exp/kprc) and every command is framed as
+ a background job of it: stdout/stderr go to fifos created per command and
+ the job pid and exit status come back on a control pipe. this saves the
+ fork/exec of a fresh shell per run. when the shell isn't available the
+ command runs with bproc like before. commands starting with '/' are api
+ paths served by kapi.c. stdin of a command is always empty.
+*/
+#include "kt.h"
+
+#if defined(__UNIX__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/* upper bound on waiting for a cancelled job to report its exit */
+#define EXIT_TIMEOUT 2000
+/* upper bound on waiting for a new shell to answer */
+#define SPAWN_TIMEOUT 2000
+
+struct _kshell_t
+{
+    int pid;
+    int in;
+    int ctl;
+    uint32_t seq;
+    uint32_t line_len;
+    char_t line[64];
+};
+
+struct _kproc_t
+{
+    Proc *proc;
+    Kapi *api;
+    Kshell *shell;
+    String *fifo_out;
+    String *fifo_err;
+    int out;
+    int err;
+    int hold_out;
+    int hold_err;
+    int pgid;
+    uint32_t code;
+    bool_t exited;
+};
+
+#if defined(__UNIX__)
+
+/*---------------------------------------------------------------------------*/
+
+static void i_cloexec(int fd)
+{
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_close(int *fd)
+{
+    if (*fd != -1)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_alive(const Kshell *shell)
+{
+    return shell->pid > 0 && waitpid(shell->pid, NULL, WNOHANG) == 0 ? TRUE : FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_write_all(int fd, const char_t *data, uint32_t len)
+{
+    while (len)
+    {
+        ssize_t w = write(fd, data, len);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        data += w;
+        len -= (uint32_t)w;
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_reap(Kshell *shell);
+
+/*---------------------------------------------------------------------------*/
+
+/* "R" on the control pipe once the shell runs, eof if bash couldn't be exec'd */
+static bool_t i_ready(Kshell *shell)
+{
+    struct pollfd fds[1];
+    char_t rec[2];
+    fds[0].fd = shell->ctl;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    if (poll(fds, 1, SPAWN_TIMEOUT) <= 0)
+        return FALSE;
+    /* a write this small reaches the pipe at once */
+    return read(shell->ctl, rec, sizeof(rec)) == sizeof(rec) && rec[0] == 'R' ? TRUE : FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the job gets its own process group with monitor mode, that's what cancel signals */
+static bool_t i_spawn(Kshell *shell)
+{
+    /* -m at startup is refused without a terminal, set is not */
+    const char_t *init = "set -m; printf 'R\\n' >&3\n";
+    int in[2], ctl[2];
+    if (pipe(in) == -1)
+        return FALSE;
+
+    if (pipe(ctl) == -1)
+    {
+        close(in[0]);
+        close(in[1]);
+        return FALSE;
+    }
+
+    shell->pid = fork();
+    if (shell->pid == -1)
+    {
+        close(in[0]);
+        close(in[1]);
+        close(ctl[0]);
+        close(ctl[1]);
+        return FALSE;
+    }
+    else if (shell->pid == 0)
+    {
+        int fds[5], i;
+        fds[0] = in[0];
+        fds[1] = in[1];
+        fds[2] = ctl[0];
+        fds[3] = ctl[1];
+        fds[4] = open("/dev/null", O_RDWR);
+        dup2(in[0], STDIN_FILENO);
+        dup2(fds[4], STDOUT_FILENO);
+        /* job notices of monitor mode */
+        dup2(fds[4], STDERR_FILENO);
+        if (ctl[1] != 3)
+            dup2(ctl[1], 3);
+        /* any of them may have been 3 */
+        for (i = 0; i < 5; ++i)
+        {
+            if (fds[i] > 3)
+                close(fds[i]);
+        }
+        setsid();
+        execlp("bash", "bash", "--noprofile", "--norc", NULL);
+        _exit(127);
+    }
+
+    close(in[0]);
+    close(ctl[1]);
+    i_cloexec(in[1]);
+    i_cloexec(ctl[0]);
+    fcntl(ctl[0], F_SETFL, fcntl(ctl[0], F_GETFL) | O_NONBLOCK);
+    shell->in = in[1];
+    shell->ctl = ctl[0];
+    shell->line_len = 0;
+    if (!i_write_all(shell->in, init, str_len_c(init)) || !i_ready(shell))
+    {
+        i_reap(shell);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_reap(Kshell *shell)
+{
+    i_close(&shell->in);
+    i_close(&shell->ctl);
+    if (shell->pid > 0)
+    {
+        kill(-shell->pid, SIGHUP);
+        waitpid(shell->pid, NULL, 0);
+        shell->pid = -1;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* single quoted so the command can't break the framing around it */
+static String *i_frame(const Kproc *proc, const char_t *command)
+{
+    String *frame = str_c("( exec 3>&-; eval '");
+    const char_t *ptr = command, *quote;
+    while ((quote = str_str(ptr, "'")) != NULL)
+    {
+        String *part = str_cn(ptr, (uint32_t)(quote - ptr));
+        str_cat(&frame, tc(part));
+        str_cat(&frame, "'\\''");
+        str_destroy(&part);
+        ptr = quote + 1;
+    }
+    str_cat(&frame, ptr);
+    str_cat(&frame, "' ) </dev/null >'");
+    str_cat(&frame, tc(proc->fifo_out));
+    str_cat(&frame, "' 2>'");
+    str_cat(&frame, tc(proc->fifo_err));
+    str_cat(&frame, "' & printf 'P %d\\n' $! >&3; wait $!; printf 'X %d\\n' $? >&3\n");
+    return frame;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* reads control records of the running job, "P <pgid>" once started and "X <status>" on exit */
+static void i_records(Kproc *proc, const int timeout_ms)
+{
+    Kshell *shell = proc->shell;
+    struct pollfd fds[1];
+    ssize_t rsize;
+    fds[0].fd = shell->ctl;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    if (timeout_ms && poll(fds, 1, timeout_ms) <= 0)
+        return;
+
+    while ((rsize = read(shell->ctl, shell->line + shell->line_len, sizeof(shell->line) - 1 - shell->line_len)) > 0)
+    {
+        uint32_t i, start = 0;
+        shell->line_len += (uint32_t)rsize;
+        for (i = 0; i < shell->line_len; ++i)
+        {
+            if (shell->line[i] == '\n')
+            {
+                shell->line[i] = '\0';
+                if (shell->line[start] == 'P')
+                    proc->pgid = atoi(shell->line + start + 2);
+                else if (shell->line[start] == 'X')
+                {
+                    proc->code = (uint32_t)atoi(shell->line + start + 2);
+                    proc->exited = TRUE;
+                    /* output reaches eof once whatever the job left behind closes the fifos */
+                    i_close(&proc->hold_out);
+                    i_close(&proc->hold_err);
+                }
+                start = i + 1;
+            }
+        }
+        bmem_move(cast(shell->line, byte_t), cast(shell->line + start, byte_t), shell->line_len - start);
+        shell->line_len -= start;
+    }
+
+    /* shell went away with the job */
+    if (rsize == 0 && !proc->exited)
+    {
+        proc->code = UINT32_MAX;
+        proc->exited = TRUE;
+        i_close(&proc->hold_out);
+        i_close(&proc->hold_err);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static String *i_fifo(const Kshell *shell, const char_t *ext)
+{
+    char_t name[64];
+    String *path;
+    bstd_sprintf(name, sizeof(name), "kproc.%d.%u.%s", shell->pid, shell->seq, ext);
+    path = hfile_appdata(name);
+    if (path)
+    {
+        unlink(tc(path));
+        if (mkfifo(tc(path), 0600) != 0)
+            str_destroy(&path);
+    }
+    return path;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_unlink(Kproc *proc)
+{
+    if (proc->fifo_out)
+    {
+        unlink(tc(proc->fifo_out));
+        str_destroy(&proc->fifo_out);
+    }
+    if (proc->fifo_err)
+    {
+        unlink(tc(proc->fifo_err));
+        str_destroy(&proc->fifo_err);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_open(const String *fifo, const int flags)
+{
+    int fd = open(tc(fifo), flags | O_NONBLOCK | O_CLOEXEC);
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Kproc *i_shell_exec(Kshell *shell, const char_t *command)
+{
+    Kproc *proc = heap_new0(Kproc);
+    String *frame;
+    bool_t ok;
+    proc->shell = shell;
+    proc->out = proc->err = proc->hold_out = proc->hold_err = -1;
+    shell->seq++;
+    proc->fifo_out = i_fifo(shell, "out");
+    proc->fifo_err = i_fifo(shell, "err");
+    if (proc->fifo_out && proc->fifo_err)
+    {
+        /* a fifo without writers reads as eof, ours are kept open until the job exits */
+        proc->out = i_open(proc->fifo_out, O_RDONLY);
+        proc->err = i_open(proc->fifo_err, O_RDONLY);
+        proc->hold_out = i_open(proc->fifo_out, O_WRONLY);
+        proc->hold_err = i_open(proc->fifo_err, O_WRONLY);
+    }
+
+    if (proc->out == -1 || proc->err == -1 || proc->hold_out == -1 || proc->hold_err == -1)
+    {
+        proc->exited = TRUE;
+        kproc_close(&proc);
+        return NULL;
+    }
+
+    shell->line_len = 0;
+    frame = i_frame(proc, command);
+    ok = i_write_all(shell->in, tc(frame), str_len(frame));
+    str_destroy(&frame);
+    if (!ok)
+    {
+        proc->exited = TRUE;
+        kproc_close(&proc);
+        return NULL;
+    }
+    return proc;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* NULL when commands can't be run through a shell of our own */
+Kshell *kshell_create(void)
+{
+#if defined(__UNIX__)
+    Kshell *shell = heap_new0(Kshell);
+    shell->in = shell->ctl = shell->pid = -1;
+    if (!i_spawn(shell))
+        heap_delete(&shell, Kshell);
+    return shell;
+#else
+    return NULL;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+void kshell_destroy(Kshell **shell)
+{
+    cassert_no_null(shell);
+    cassert_no_null(*shell);
+#if defined(__UNIX__)
+    i_reap(*shell);
+#endif
+    heap_delete(shell, Kshell);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* shell is optional, commands run with bproc without it or when it can't be respawned */
+Kproc *kproc_exec(Kshell *shell, const char_t *command, perror_t *error)
+{
+    Kproc *proc = NULL;
+    if (command[0] == '/')
+    {
+        proc = heap_new0(Kproc);
+        proc->api = kapi_open(command);
+        ptr_assign(error, ekPOK);
+        return proc;
+    }
+
+#if defined(__UNIX__)
+    if (shell)
+    {
+        /* the user may have killed it, it's respawned once */
+        if (!i_alive(shell))
+        {
+            i_reap(shell);
+            i_spawn(shell);
+        }
+
+        if (shell->pid > 0)
+            proc = i_shell_exec(shell, command);
+    }
+#else
+    unref(shell);
+#endif
+
+    if (!proc)
+    {
+        Proc *bproc = bproc_exec(command, error);
+        if (!bproc)
+            return NULL;
+
+        bproc_write_close(bproc);
+        proc = heap_new0(Kproc);
+        proc->proc = bproc;
+    }
+
+    ptr_assign(error, ekPOK);
+    return proc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* waits for the job to exit, it's killed if still running */
+void kproc_close(Kproc **proc)
+{
+    cassert_no_null(proc);
+    cassert_no_null(*proc);
+    if ((*proc)->proc)
+    {
+        bproc_close(&(*proc)->proc);
+    }
+    else if ((*proc)->api)
+    {
+        kapi_close(&(*proc)->api);
+    }
+#if defined(__UNIX__)
+    else
+    {
+        Kproc *p = *proc;
+        if (!p->exited)
+        {
+            i_records(p, 0);
+            if (!p->exited)
+            {
+                kproc_cancel(p);
+                i_records(p, EXIT_TIMEOUT);
+            }
+
+            if (!p->exited)
+            {
+                if (p->pgid > 0)
+                    kill(-p->pgid, SIGKILL);
+                i_records(p, EXIT_TIMEOUT);
+            }
+
+            /* framing is lost, the shell is respawned by the next exec */
+            if (!p->exited)
+                i_reap(p->shell);
+        }
+        i_close(&p->out);
+        i_close(&p->err);
+        i_close(&p->hold_out);
+        i_close(&p->hold_err);
+        i_unlink(p);
+    }
+#endif
+    heap_delete(proc, Kproc);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* only the open streams are waited on, one at its end would wake the poll right away */
+bool_t kproc_poll(Kproc *proc, const bool_t out, const bool_t err, const uint32_t timeout_ms)
+{
+    cassert_no_null(proc);
+    if (proc->proc)
+        return bproc_poll(proc->proc, out, err, timeout_ms);
+    if (proc->api)
+        return kapi_poll(proc->api, timeout_ms);
+#if defined(__UNIX__)
+    {
+        struct pollfd fds[3];
+        int ret;
+        fds[0].fd = out ? proc->out : -1;
+        fds[1].fd = err ? proc->err : -1;
+        fds[2].fd = proc->exited ? -1 : proc->shell->ctl;
+        fds[0].events = fds[1].events = fds[2].events = POLLIN;
+        fds[0].revents = fds[1].revents = fds[2].revents = 0;
+        ret = poll(fds, 3, timeout_ms == UINT32_MAX ? -1 : (int)timeout_ms);
+        if (ret > 0 && fds[2].revents)
+        {
+            i_records(proc, 0);
+            /* only the exit record, output may be at eof now */
+            if (!fds[0].revents && !fds[1].revents)
+                return proc->exited;
+        }
+        return ret > 0 ? TRUE : FALSE;
+    }
+#else
+    return FALSE;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t kproc_cancel(Kproc *proc)
+{
+    cassert_no_null(proc);
+    if (proc->proc)
+        return bproc_cancel(proc->proc);
+    /* the reader stops reading, closing drops the connection */
+    if (proc->api)
+        return TRUE;
+#if defined(__UNIX__)
+    /* job is started right after the frame is written */
+    if (!proc->pgid && !proc->exited)
+        i_records(proc, EXIT_TIMEOUT);
+
+    if (proc->pgid > 0 && !proc->exited)
+        return kill(-proc->pgid, SIGHUP) == 0 ? TRUE : FALSE;
+#endif
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t kproc_finish(Kproc *proc, uint32_t *code)
+{
+    cassert_no_null(proc);
+    if (proc->proc)
+        return bproc_finish(proc->proc, code);
+    if (proc->api)
+        return kapi_finish(proc->api, code);
+#if defined(__UNIX__)
+    if (!proc->exited)
+        i_records(proc, 0);
+#endif
+    if (proc->exited)
+        ptr_assign(code, proc->code);
+    return proc->exited;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(__UNIX__)
+
+static bool_t i_read(int fd, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    ssize_t lrsize = read(fd, cast(data, char), (size_t)size);
+    if (lrsize > 0)
+    {
+        ptr_assign(rsize, (uint32_t)lrsize);
+        ptr_assign(error, ekPOK);
+        return TRUE;
+    }
+
+    ptr_assign(rsize, 0);
+    if (lrsize == 0)
+    {
+        ptr_assign(error, ekPOK);
+    }
+    else if (errno == EAGAIN)
+    {
+        ptr_assign(error, ekPAGAIN);
+    }
+    else
+    {
+        ptr_assign(error, ekPPIPE);
+    }
+    return FALSE;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* same contract as bproc_read, FALSE with ekPOK is eof */
+bool_t kproc_read(Kproc *proc, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    cassert_no_null(proc);
+    if (proc->proc)
+        return bproc_read(proc->proc, data, size, rsize, error);
+    if (proc->api)
+        return kapi_read(proc->api, data, size, rsize, error);
+#if defined(__UNIX__)
+    return i_read(proc->out, data, size, rsize, error);
+#else
+    return FALSE;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t kproc_eread(Kproc *proc, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error)
+{
+    cassert_no_null(proc);
+    if (proc->proc)
+        return bproc_eread(proc->proc, data, size, rsize, error);
+    if (proc->api)
+        return kapi_eread(proc->api, data, size, rsize, error);
+#if defined(__UNIX__)
+    return i_read(proc->err, data, size, rsize, error);
+#else
+    return FALSE;
+#endif
+}
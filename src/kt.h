@@ -14,10 +14,24 @@ more than 64Ki is increasing overall time with current way of doing I/O
 on my machine (fedora 40)
  */
 #define READ_BUFFER (64 * 1024)
-#define MAX_OUT_SIZE (512 * 1024)
+/* reading happens on the task thread (reader.c), gui only checks for new data every frame */
+#define READ_UPDATE_TIME .01f
+/* how long the task waits for an exit code once the output is closed */
+#define EXIT_WAIT 1000
+/* chunks of READ_BUFFER between reader and gui, reader stops reading when all are in use */
+#define RING_CHUNKS 64
+/* bytes the gui consumes per update, keeps the frame time bounded, pipe reads rarely fill a chunk */
+#define FRAME_BYTES (16 * READ_BUFFER)
 #define MAX_ERR_SIZE (256 * 1024)
+/* stderr kept for search, in bytes, enough for the MAX_ERR_SIZE characters the view shows */
+#define ERR_KEEP (4 * (MAX_ERR_SIZE + 1))
+/* bytes a search task scans between two checks for a cancel */
+#define SEARCH_SLICE (256 * 1024)
+/* starts kept to narrow a search as its pattern grows, 16 MiB */
+#define SEARCH_CANDS (4 * 1024 * 1024)
+/* stdout below this is scanned about as fast as the index answers, its tables take about a byte per byte of stdout (16 MiB at most) while built */
+#define INDEX_MIN_SIZE (4 * 1024 * 1024)
 #define INITIAL_PARSE_SIZE (4 * 1024 * 1024)
-#define INCR_PARSE_SIZE (2 * 1024 * 1024)
 
 typedef enum _run_t
 {
@@ -28,6 +42,23 @@ typedef enum _run_t
     ktRUN_ENDED
 } run_t;
 
+/* what the memory audit tells apart */
+typedef enum _mem_t
+{
+    ktMEM_YYJSON,
+    ktMEM_BORON,
+    ktMEM_TEXT,
+    ktMEM_COUNT
+} mem_t;
+
+typedef struct _memstat_t MemStat;
+struct _memstat_t
+{
+    uint64_t live;
+    uint64_t peak;
+    uint64_t allocs;
+};
+
 typedef struct _destroyer_t Destroyer;
 typedef void (*FPtr_closure)(const Destroyer *context);
 #define FUNC_CHECK_CLOSURE(func, type) \
@@ -42,14 +73,33 @@ DeclPt(Destroyer);
 
 typedef struct _inops_t opsv;
 typedef struct _history_t History;
+typedef struct _reader_t Reader;
+typedef struct _kshell_t Kshell;
+typedef struct _kproc_t Kproc;
+typedef struct _kapi_t Kapi;
+typedef struct _ring_t Ring;
+typedef struct _chunk_t Chunk;
+typedef struct _spool_t Spool;
+typedef struct _scanner_t Scanner;
+typedef struct _watch_t Watch;
+typedef struct _sdata_t Sdata;
+typedef struct _idata_t Idata;
+typedef struct _pdata_t Pdata;
+typedef struct _pview_t Pview;
+typedef struct _trigram_t Trigram;
+typedef struct _keymap_t Keymap;
+typedef struct _framer_t Framer;
+typedef struct _utf8_t Utf8;
+struct _chunk_t
+{
+    byte_t *data;
+    uint32_t len;
+    bool_t err;
+};
 
-typedef struct line line;
 typedef struct _app_t App;
 struct _app_t
 {
-    byte_t read_buf[READ_BUFFER];
-    byte_t *parse_buf;
-    uint32_t parse_size;
     S2Df dsize;
     UThread *uthread;
 
@@ -62,40 +112,70 @@ struct _app_t
     Button *tail;
     Edit *search;
     Button *err_search;
+    Button *regex;
     Button *noshow;
     Cell *nolimitb;
-    TextView *cmdout;
+    LogView *cmdout;
     TextView *cmderr;
     Label *status;
     opsv *locker;
 
-    const char_t *start_ptr;
+    /* search task that fills pos_cache, NULL once all matches are known */
+    Sdata *sdata;
+    /* start, length pairs of the matches */
     ArrSt(uint32_t) *pos_cache;
-    Proc *proc;
+    /* every start of the last complete literal search and its pattern, NULL when unknown */
+    ArrSt(uint32_t) *cands;
+    byte_t *cand_pat;
+    uint32_t cand_plen;
+    /* task that indexes stdout once a run ends, then the index, NULL until built */
+    Idata *idata;
+    Trigram *index;
+    /* task that parses the capture once a run completes, the run ends with it */
+    Pdata *pdata;
+    Kproc *proc;
+    Kshell *shell;
+    Reader *reader;
+    Spool *spool;
+    Scanner *scanner;
+    Watch *watch;
     History *hist;
-    uint32_t rsize;
     uint32_t cur_idx;
-    uint32_t end_len;
-    uint32_t pat_len;
     uint32_t out_len;
+    /* last ERR_KEEP bytes of stderr, ERR_KEEP + 1 allocated, from err_new on not shown yet */
+    byte_t *err_text;
     uint32_t err_len;
+    uint32_t err_new;
+    /* bytes the output views hold as last told to the audit */
+    uint32_t text_audit;
     uint32_t cpos;
+    /* exit code of the last run, UINT32_MAX when it isn't known */
+    uint32_t code;
     run_t run_state;
-    bool_t stop;
     bool_t nolimit;
     bool_t complete;
     bool_t replace_line;
+    /* the window was closed during a parse, the app finishes when the parse ends */
+    bool_t closing;
 
     yyjson_mut_doc *doc;
     yyjson_alc *alc;
 
     ArrPt(Destroyer) *views;
+    /* table that later output is added to (watch events, pages), one of views */
+    Destroyer *table;
+    /* path of a paged api list, of its next page and where the capture of the current page starts */
+    String *page_path;
+    String *page_next;
+    uint32_t page_off;
 
-    char_t cur_line[256];
-    uint32_t cur_start;
+    /* replace mode, lines of the output and the view line of every key seen */
+    Framer *framer;
     uint32_t line_num;
-    SetSt(line) *dict;
-    ArrSt(line_pos) *pos_lens;
+    /* hold utf8 sequences cut between chunks */
+    Utf8 *out_utf8;
+    Utf8 *err_utf8;
+    Keymap *dict;
 };
 
 /*
@@ -120,7 +200,9 @@ extern char_t const *st_running;
 extern char_t const *st_stopping;
 extern char_t const *st_stopped;
 extern char_t const *st_completed;
+extern char_t const *st_parsing;
 extern char_t const *st_unknown;
+extern char_t const *st_exited;
 extern char_t const *bt_run;
 extern char_t const *bt_stop;
 
@@ -131,13 +213,25 @@ void lock_view(opsv *locker, bool_t lock);
 /* TODO: end */
 
 /* TODO: populate_views should eventually accept a shared struct for all the views */
-void populate_views(App *app);
+Pview *pview_create(App *app);
+bool_t pview_step(Pview *pv, uint32_t *done, uint32_t *total);
+void pview_destroy(Pview **pv);
+void populate_views(App *app, Pview **pv);
+void populate_watch(App *app, yyjson_doc *event);
+String *populate_page(App *app);
+void refresh_table(App *app);
 void adjust_vscroll(Layout *vscroll, const uint32_t selected, const uint32_t total);
 void cols_bind(void);
 
-yyjson_alc *alc_init(const char_t *name);
+yyjson_alc *alc_init(const char_t *name, const mem_t mem);
+void alc_reset(yyjson_alc *alc);
 void alc_dest(yyjson_alc **alc);
 
+void audit_alloc(const mem_t mem, const size_t size);
+void audit_free(const mem_t mem, const size_t size);
+void audit_sample(void);
+void audit_read(MemStat *stats);
+
 UThread *uthread_create(void);
 void uthread_destroy(UThread **ut);
 void update_jroot(UThread *ut, yyjson_mut_val *jroot);
@@ -152,3 +246,86 @@ History *history_load(void);
 bool_t history_append(History *hist, byte_t *data, uint32_t len);
 uint32_t history_search(History *hist, byte_t *prefix, uint32_t prefix_len, byte_t *match, uint32_t max_len);
 void history_flush(History **hist);
+
+Kshell *kshell_create(void);
+void kshell_destroy(Kshell **shell);
+Kproc *kproc_exec(Kshell *shell, const char_t *command, perror_t *error);
+void kproc_close(Kproc **proc);
+bool_t kproc_poll(Kproc *proc, const bool_t out, const bool_t err, const uint32_t timeout_ms);
+bool_t kproc_cancel(Kproc *proc);
+bool_t kproc_finish(Kproc *proc, uint32_t *code);
+bool_t kproc_read(Kproc *proc, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error);
+bool_t kproc_eread(Kproc *proc, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error);
+
+Kapi *kapi_open(const char_t *path);
+void kapi_close(Kapi **api);
+bool_t kapi_poll(Kapi *api, const uint32_t timeout_ms);
+bool_t kapi_read(Kapi *api, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error);
+bool_t kapi_eread(Kapi *api, byte_t *data, const uint32_t size, uint32_t *rsize, perror_t *error);
+bool_t kapi_finish(const Kapi *api, uint32_t *code);
+bool_t kapi_paged(const char_t *command);
+String *kapi_page(const char_t *path, const char_t *token);
+
+Reader *reader_create(void);
+void reader_destroy(Reader **reader);
+void reader_start(Reader *reader);
+bool_t reader_run(Reader *reader, Kproc *proc);
+Chunk *reader_chunk(Reader *reader);
+void reader_release(Reader *reader);
+void reader_stop(Reader *reader);
+void reader_cancel(Reader *reader);
+
+Ring *ring_create(const uint32_t nchunks, const uint32_t chunk_size);
+void ring_destroy(Ring **ring);
+void ring_clear(Ring *ring);
+uint32_t ring_chunk_size(const Ring *ring);
+Chunk *ring_produce(Ring *ring);
+void ring_publish(Ring *ring);
+Chunk *ring_consume(Ring *ring);
+void ring_release(Ring *ring);
+
+Spool *spool_create(void);
+void spool_destroy(Spool **spool);
+void spool_reset(Spool *spool);
+bool_t spool_append(Spool *spool, const byte_t *data, const uint32_t size);
+byte_t *spool_data(Spool *spool);
+uint32_t spool_len(const Spool *spool);
+uint32_t spool_size(const Spool *spool);
+
+Scanner *scanner_create(yyjson_alc *alc);
+void scanner_destroy(Scanner **scanner);
+void scanner_reset(Scanner *scanner);
+void scanner_feed(Scanner *scanner, const byte_t *data, const uint32_t len);
+yyjson_mut_doc *scanner_finish(Scanner *scanner, const byte_t *data, const uint32_t len);
+
+Watch *watch_create(yyjson_alc *alc);
+void watch_destroy(Watch **watch);
+void watch_reset(Watch *watch);
+void watch_ignore(Watch *watch);
+bool_t watch_feed(Watch *watch, const byte_t *data, const uint32_t len);
+yyjson_doc *watch_next(Watch *watch);
+
+uint32_t find_bytes(const byte_t *text, const uint32_t len, const byte_t *pattern, const uint32_t plen);
+
+Trigram *trigram_create(const uint32_t size);
+void trigram_destroy(Trigram **tri);
+void trigram_line(Trigram *tri, const byte_t *text, const uint32_t len, const uint32_t pos);
+void trigram_seal(Trigram *tri);
+void trigram_lines(const Trigram *tri, const byte_t *pattern, const uint32_t plen, ArrSt(uint32_t) *starts);
+
+Keymap *keymap_create(void);
+void keymap_destroy(Keymap **map);
+void keymap_clear(Keymap *map);
+bool_t keymap_insert(Keymap *map, const byte_t *key, const uint32_t len, uint32_t *value);
+
+Framer *framer_create(void);
+void framer_destroy(Framer **framer);
+void framer_reset(Framer *framer);
+void framer_feed(Framer *framer, const byte_t *data, const uint32_t size);
+bool_t framer_next(Framer *framer, const byte_t **line, uint32_t *len);
+
+Utf8 *utf8_create(void);
+void utf8_destroy(Utf8 **utf8);
+void utf8_reset(Utf8 *utf8);
+void utf8_feed(Utf8 *utf8, byte_t *data, const uint32_t size);
+bool_t utf8_next(Utf8 *utf8, const byte_t **text, uint32_t *len);
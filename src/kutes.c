@@ -3,24 +3,13 @@
 #include <boron.h>
 #include <yyjson.h>
 #include <nappgui.h>
+#include <string.h>
 
-byte_t bmatch[kTEXTFILTER_SIZE];
-
-struct line
-{
-    char_t name[80];
-    uint32_t num;
-};
-DeclSt(line);
-
-typedef struct line_pos
-{
-    uint32_t start;
-    uint32_t end;
-} line_pos;
-DeclSt(line_pos);
+#if defined(__UNIX__)
+#include <signal.h>
+#endif
 
-/*---------------------------------------------------------------------------*/
+byte_t bmatch[kTEXTFILTER_SIZE];
 
 struct _inops_t
 {
@@ -33,20 +22,34 @@ struct _inops_t
 static const char_t *bt_wrap = "&wrap";
 static const char_t *bt_tail = "&tail";
 static const char_t *bt_err_search = "std&err";
+static const char_t *bt_regex = "re&gex";
+static const char_t *st_search = "⌕ %u/%u%s"; /* U+2315 */
+static const char_t *st_bad_regex = "⌕ bad regex";
 
 static const char_t *info = "\
-only last 512 KiB of stdout data is displayed here.\n\n\
+all of stdout is displayed here, only the visible lines are drawn.\n\n\
 checking 'stderr' searches stderr text or 'stdout' by default.\n\n\
+'regex' searches with a regular expression, matches don't span lines.\n\n\
 'noshow' suppresses stdout display but still stored for parsing.\n\n\
 if 'nolimit' is checked full stdout is stored for parsing or limited to 4 MiB.\
 ";
 
 /*---------------------------------------------------------------------------*/
 
+/* output reaches its end a moment before the exit is reported */
 static uint32_t bg_proc_main(App *app)
 {
-    bproc_wait_exit(&app->proc);
-    return 0;
+    uint32_t waited = 0;
+    app->code = UINT32_MAX;
+    if (!reader_run(app->reader, app->proc))
+        return ktRUN_CANCEL;
+
+    while (!kproc_finish(app->proc, &app->code) && waited < EXIT_WAIT)
+    {
+        bthread_sleep(10);
+        waited += 10;
+    }
+    return ktRUN_COMPLETE;
 }
 
 static void replace_line(App *app, Event *e)
@@ -99,162 +102,511 @@ static void i_OnEditChange(App *app, Event *e)
     app->cpos = p->cpos;
 }
 
-static int line_cmp(const line *a, const line *b)
+/* keyed on the first field, a known key rewrites its line in place */
+static void replace_result(App *app, byte_t *data, const uint32_t size)
 {
-    return blib_strcmp(a->name, b->name);
-}
-
-static void replace_result(App *app)
-{
-    uint32_t i;
-    line *val, key;
-    line_pos pos_new, *pos_old;
-    for (i = 0; i < app->rsize; ++i)
+    const byte_t *span = NULL, *text = NULL;
+    uint32_t slen = 0, len = 0;
+    utf8_feed(app->out_utf8, data, size);
+    while (utf8_next(app->out_utf8, &span, &slen) == TRUE)
     {
-        if (app->read_buf[i] == '\n')
+        framer_feed(app->framer, span, slen);
+        while (framer_next(app->framer, &text, &len) == TRUE)
         {
-            uint32_t space;
-            for (space = 0; space < app->cur_start && app->cur_line[space] != ' '; ++space)
+            const byte_t *space = cast_const(memchr(text, ' ', len), byte_t);
+            uint32_t klen = space ? (uint32_t)(space - text) : len;
+            uint32_t num = app->line_num;
+            if (keymap_insert(app->dict, text, klen, &num) == TRUE)
             {
-            }
-
-            app->cur_line[app->cur_start] = '\n';
-            app->cur_line[app->cur_start + 1] = '\0';
-
-            bmem_copy(cast(key.name, byte_t), cast(app->cur_line, byte_t), space);
-            key.name[space] = '\0';
-            val = setst_get(app->dict, &key, line, line);
-            if (val)
-            {
-                int32_t diff = 0;
-                pos_old = arrst_get(app->pos_lens, val->num, line_pos);
-                textview_select(app->cmdout, -1, -1);
-                textview_select(app->cmdout, pos_old->start, pos_old->end + 1);
-                textview_cpos_printf(app->cmdout, "%s", app->cur_line);
-
-                diff = (pos_old->start + app->cur_start - pos_old->end);
-                pos_old->end += diff;
-                textview_select(app->cmdout, pos_old->start, pos_old->end);
-                /* propagate the diff to succeeding lines */
-                if (diff && val->num < app->line_num)
-                {
-                    uint32_t st = val->num + 1;
-                    pos_old = arrst_all(app->pos_lens, line_pos);
-                    pos_old += st;
-                    for (; st < app->line_num; st++, pos_old++)
-                    {
-                        pos_old->start += diff;
-                        pos_old->end += diff;
-                    }
-                }
+                /* with the newline that follows it */
+                logview_write(app->cmdout, cast_const(text, char_t), len + 1);
+                app->line_num++;
             }
             else
             {
-                val = setst_insert(app->dict, &key, line, line);
-                cassert_no_null(val);
-                blib_strcpy(val->name, 80, key.name);
-                val->num = app->line_num;
-
-                if (app->line_num > 0)
-                {
-                    line_pos *prev = arrst_get(app->pos_lens, app->line_num - 1, line_pos);
-                    pos_new.start = pos_new.end = prev->end + 1;
-                }
-                else
-                {
-                    pos_new.start = pos_new.end = 0;
-                }
-                pos_new.end += app->cur_start;
-                arrst_append(app->pos_lens, pos_new, line_pos);
-                textview_select(app->cmdout, -1, -1);
-                textview_printf(app->cmdout, "%s", app->cur_line);
-                app->line_num++;
+                /* the view moves the offsets of the following lines */
+                logview_line(app->cmdout, num, cast_const(text, char_t), len);
             }
-            app->cur_start = 0;
         }
-        else
+    }
+}
+
+static void write_result(App *app, byte_t *data, const uint32_t size)
+{
+    if (watch_feed(app->watch, data, size))
+    {
+        /* a watch doesn't end, its events patch the table instead of being captured */
+        yyjson_doc *event;
+        if (spool_len(app->spool))
+        {
+            scanner_reset(app->scanner);
+            spool_reset(app->spool);
+        }
+        while ((event = watch_next(app->watch)) != NULL)
         {
-            app->cur_line[app->cur_start++] = app->read_buf[i];
+            populate_watch(app, event);
+            yyjson_doc_free(event);
         }
     }
-    textview_scroll_caret(app->cmdout);
+    /* spool_len stays behind the page once something isn't captured, views aren't populated then */
+    else if (spool_len(app->spool) == app->out_len - app->page_off && (app->nolimit || spool_len(app->spool) < INITIAL_PARSE_SIZE))
+    {
+        if (spool_append(app->spool, data, size))
+            scanner_feed(app->scanner, spool_data(app->spool), spool_len(app->spool));
+    }
+
+    app->out_len += size;
+    if (button_get_state(app->noshow) == ekGUI_OFF)
+    {
+        /* the capture keeps the raw bytes, the view gets valid utf8 */
+        const byte_t *text = NULL;
+        uint32_t len = 0;
+        utf8_feed(app->out_utf8, data, size);
+        while (utf8_next(app->out_utf8, &text, &len) == TRUE)
+            logview_write(app->cmdout, cast_const(text, char_t), len);
+    }
 }
 
-static void write_result(App *app)
+/* start of the last max characters of text[st, ed) */
+static uint32_t i_last_chars(const byte_t *text, const uint32_t st, uint32_t ed, const uint32_t max)
 {
-    if (app->nolimit && app->out_len + app->rsize > app->parse_size)
+    uint32_t n = 0;
+    while (ed > st)
     {
-        /* TODO: what if this fails and old pointer is lost?, in assert mode this throws a fatal error */
-        app->parse_buf = heap_realloc_n(app->parse_buf, app->parse_size, app->parse_size + INCR_PARSE_SIZE, byte_t);
-        app->parse_size += INCR_PARSE_SIZE;
+        ed--;
+        if ((text[ed] & 0xC0) != 0x80 && ++n == max)
+            break;
     }
+    return ed;
+}
 
-    if (app->nolimit || app->out_len < INITIAL_PARSE_SIZE)
-        bmem_copy(app->parse_buf + (app->out_len * sizeof(char_t)), app->read_buf, app->rsize);
+/* characters in text[st, ed) */
+static uint32_t i_count_chars(const byte_t *text, uint32_t st, const uint32_t ed)
+{
+    uint32_t n = 0;
+    for (; st < ed; ++st)
+    {
+        if ((text[st] & 0xC0) != 0x80)
+            n++;
+    }
+    return n;
+}
 
-    app->read_buf[app->rsize] = '\0';
-    app->out_len += app->rsize;
-    if (button_get_state(app->noshow) == ekGUI_OFF)
+/* kept for search, the view gets it once per frame */
+static void write_error(App *app, const byte_t *data, const uint32_t size)
+{
+    uint32_t keep = min_u32(size, ERR_KEEP);
+    const byte_t *src = data + size - keep;
+    if (app->err_len + keep > ERR_KEEP)
+    {
+        /* whole utf8 sequences are dropped from the front */
+        uint32_t drop = app->err_len + keep - ERR_KEEP;
+        while (drop < app->err_len && (app->err_text[drop] & 0xC0) == 0x80)
+            drop++;
+        bmem_move(app->err_text, app->err_text + drop, app->err_len - drop);
+        app->err_len -= drop;
+        app->err_new = app->err_new > drop ? app->err_new - drop : 0;
+    }
+
+    while (keep > 0 && keep < size && (*src & 0xC0) == 0x80)
+    {
+        src++;
+        keep--;
+    }
+
+    bmem_copy(app->err_text + app->err_len, src, keep);
+    app->err_len += keep;
+}
+
+/* the frame's stderr as one insert and one trim of the front, FALSE if there was none */
+static bool_t i_flush_error(App *app)
+{
+    uint32_t st = 0;
+    if (app->err_new == app->err_len)
+        return FALSE;
+    /* more than the view keeps from one frame would leave a gap in it */
+    st = i_last_chars(app->err_text, app->err_new, app->err_len, MAX_ERR_SIZE);
+    app->err_text[app->err_len] = '\0';
+    textview_append(app->cmderr, cast(app->err_text + st, char_t), MAX_ERR_SIZE);
+    app->err_new = app->err_len;
+    return TRUE;
+}
+
+/* text held for the views goes to the audit as a difference, then the peaks are sampled */
+static void i_audit_text(App *app)
+{
+    uint32_t bytes = logview_bytes(app->cmdout) + app->err_len;
+    if (bytes > app->text_audit)
+        audit_alloc(ktMEM_TEXT, bytes - app->text_audit);
+    else if (bytes < app->text_audit)
+        audit_free(ktMEM_TEXT, app->text_audit - bytes);
+    app->text_audit = bytes;
+    /* a short lived parse or page would be missed by the status bar reads alone */
+    audit_sample();
+}
+
+/*
+ consumes chunks from the reader in place until max_bytes, FALSE if nothing was read.
+ the views are committed once at the end, err tells if stderr was part of it
+*/
+static bool_t i_run_drain(App *app, const uint32_t max_bytes, bool_t *err)
+{
+    Chunk *chunk;
+    uint32_t n = 0, bytes = 0;
+    while (bytes < max_bytes && (chunk = reader_chunk(app->reader)) != NULL)
     {
-        if (app->out_len > MAX_OUT_SIZE)
+        if (chunk->err)
         {
-            textview_select(app->cmdout, 0, app->rsize);
-            textview_del_select(app->cmdout);
-            textview_select(app->cmdout, -1, -1);
+            const byte_t *text = NULL;
+            uint32_t len = 0;
+            utf8_feed(app->err_utf8, chunk->data, chunk->len);
+            while (utf8_next(app->err_utf8, &text, &len) == TRUE)
+                write_error(app, text, len);
         }
-        textview_writef(app->cmdout, cast(app->read_buf, char_t));
+        else if (app->replace_line)
+            replace_result(app, chunk->data, chunk->len);
+        else
+            write_result(app, chunk->data, chunk->len);
+        bytes += chunk->len;
+        reader_release(app->reader);
+        n++;
     }
+
+    if (n == 0)
+        return FALSE;
+
+    if (i_flush_error(app) && err)
+        *err = TRUE;
+    logview_update(app->cmdout);
+    i_audit_text(app);
+    return TRUE;
 }
 
+/*---------------------------------------------------------------------------*/
+
+/* a utf8 sequence cut by the end of the output is shown as '?' */
+static void i_run_tail(App *app)
+{
+    const byte_t *text = NULL;
+    uint32_t len = 0;
+    utf8_feed(app->out_utf8, NULL, 0);
+    while (utf8_next(app->out_utf8, &text, &len) == TRUE)
+    {
+        if (app->replace_line == FALSE && button_get_state(app->noshow) == ekGUI_OFF)
+            logview_write(app->cmdout, cast_const(text, char_t), len);
+    }
+
+    utf8_feed(app->err_utf8, NULL, 0);
+    while (utf8_next(app->err_utf8, &text, &len) == TRUE)
+        write_error(app, text, len);
+    i_flush_error(app);
+    logview_update(app->cmdout);
+    i_audit_text(app);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_run_update(App *app)
 {
-    perror_t out, err;
-    bool_t read0 = TRUE;
-    if (app->run_state != ktRUN_INPROGRESS)
+    bool_t err = FALSE;
+    /* bounded so a fast producer can't stall the frame, the rest waits in the ring */
+    if (i_run_drain(app, FRAME_BYTES, &err))
     {
-        return;
+        refresh_table(app);
+        if (button_get_state(app->tail) == ekGUI_ON)
+        {
+            logview_scroll_caret(app->cmdout);
+            if (err)
+                textview_scroll_caret(app->cmderr);
+        }
     }
-    else if (app->stop)
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_run_end(App *app, const uint32_t rval);
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_run_start(App *app, const char_t *cmd)
+{
+    app->proc = kproc_exec(app->shell, cmd, NULL);
+    if (!app->proc)
     {
-        bproc_cancel(app->proc);
-        bproc_close(&app->proc);
-        app->run_state = ktRUN_CANCEL;
-        return;
+        label_text(app->status, st_unknown);
+        return FALSE;
+    }
+    app->run_state = ktRUN_INPROGRESS;
+    edit_editable(app->cmdin, FALSE);
+    cell_enabled(app->nolimitb, FALSE);
+    cell_enabled(app->replace, FALSE);
+    label_text(app->status, st_running);
+    button_text(app->run, bt_stop);
+    utf8_reset(app->out_utf8);
+    utf8_reset(app->err_utf8);
+    if (app->replace_line)
+    {
+        app->line_num = 0;
+        framer_reset(app->framer);
+        app->dict = keymap_create();
     }
+    reader_start(app->reader);
+    osapp_task(app, READ_UPDATE_TIME, bg_proc_main, i_run_update, i_run_end, App);
+    return TRUE;
+}
 
-    if (bproc_read(app->proc, app->read_buf, READ_BUFFER - 1, &app->rsize, &out))
+/*---------------------------------------------------------------------------*/
+
+/* next page is started on idle, this is called from the scheduler cycle that osapp_task adds to */
+static void i_OnPage(App *app, Event *e)
+{
+    String *path = app->page_next;
+    app->page_next = NULL;
+    if (!path || !i_run_start(app, tc(path)))
+        i_run_end(app, ktRUN_CANCEL);
+    str_destopt(&path);
+    unref(e);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* TRUE if there is a next page of the paged list to fetch */
+static bool_t i_run_page(App *app)
+{
+    String *token = populate_page(app);
+    if (token)
     {
-        if (app->replace_line)
-            replace_result(app);
-        else
-            write_result(app);
-        read0 = FALSE;
+        app->page_next = kapi_page(tc(app->page_path), tc(token));
+        str_destroy(&token);
+        /* the capture of the page is in the table now */
+        scanner_reset(app->scanner);
+        spool_reset(app->spool);
+        app->page_off = app->out_len;
+        gui_OnIdle(listener(app, i_OnPage, App));
+        return TRUE;
     }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* indexes stdout once a run ends, the view is only read with the mutex held like a search does */
+struct _idata_t
+{
+    App *app;
+    Mutex *mutex;
+    const LogView *view;
+    Trigram *tri;
+    bool_t cancel;
+};
+
+/*---------------------------------------------------------------------------*/
 
-    if (bproc_eread(app->proc, app->read_buf, READ_BUFFER - 1, &app->rsize, &err))
+/* two passes over the lines, a cancel ends both at once */
+static uint32_t bg_index_main(Idata *data)
+{
+    uint32_t pass;
+    for (pass = 0; pass < 2; ++pass)
     {
-        app->read_buf[app->rsize] = '\0';
-        app->err_len += app->rsize;
-        if (app->err_len > MAX_ERR_SIZE)
+        uint32_t from = 0;
+        bool_t more = TRUE;
+        while (more)
         {
-            textview_select(app->cmderr, 0, app->rsize);
-            textview_del_select(app->cmderr);
-            textview_select(app->cmderr, -1, -1);
+            uint32_t scanned = 0;
+            bmutex_lock(data->mutex);
+            while (more && scanned < SEARCH_SLICE)
+            {
+                uint32_t len = 0;
+                const byte_t *text = NULL;
+                if (data->cancel == FALSE)
+                    text = cast_const(logview_text(data->view, from, &len), byte_t);
+
+                if (text == NULL)
+                {
+                    more = FALSE;
+                }
+                else
+                {
+                    trigram_line(data->tri, text, len, from);
+                    from += len + 1;
+                    scanned += len + 1;
+                }
+            }
+            bmutex_unlock(data->mutex);
         }
-        textview_writef(app->cmderr, cast(app->read_buf, char_t));
-        read0 = FALSE;
+        trigram_seal(data->tri);
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_index_end(Idata *data, const uint32_t rval)
+{
+    if (data->cancel == FALSE)
+    {
+        data->app->idata = NULL;
+        data->app->index = data->tri;
+        data->tri = NULL;
+    }
+    if (data->tri != NULL)
+        trigram_destroy(&data->tri);
+    bmutex_close(&data->mutex);
+    heap_delete(&data, Idata);
+    unref(rval);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_index_start(App *app)
+{
+    Idata *data = heap_new0(Idata);
+    data->app = app;
+    data->mutex = bmutex_create();
+    data->view = app->cmdout;
+    data->tri = trigram_create(app->out_len);
+    app->idata = data;
+    osapp_task(data, READ_UPDATE_TIME, bg_index_main, NULL, i_index_end, Idata);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* posted by the end of a run like i_OnPage, the output may have changed since */
+static void i_OnIndex(App *app, Event *e)
+{
+    /* big captures get searched many times */
+    if (app->run_state == ktRUN_ENDED && app->idata == NULL && app->index == NULL && app->out_len >= INDEX_MIN_SIZE && button_get_state(app->noshow) == ekGUI_OFF)
+        i_index_start(app);
+    unref(e);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* stops the build or drops the index, the output is about to change */
+static void i_index_forget(App *app)
+{
+    if (app->idata)
+    {
+        bmutex_lock(app->idata->mutex);
+        app->idata->cancel = TRUE;
+        bmutex_unlock(app->idata->mutex);
+        app->idata = NULL;
+    }
+    if (app->index)
+        trigram_destroy(&app->index);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* parses the capture once the command completes, the run ends when the views are ready */
+struct _pdata_t
+{
+    App *app;
+    Mutex *mutex;
+    Pview *pview;
+    /* rows of the table evaluated so far */
+    uint32_t done;
+    uint32_t total;
+    bool_t cancel;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* the doc and the first pass over the table, a cancel is seen between steps */
+static uint32_t bg_parse_main(Pdata *data)
+{
+    bool_t more, cancel;
+    bmutex_lock(data->mutex);
+    cancel = data->cancel;
+    bmutex_unlock(data->mutex);
+    data->pview = cancel ? NULL : pview_create(data->app);
+    more = data->pview != NULL;
+    while (more && !cancel)
+    {
+        uint32_t done, total;
+        more = pview_step(data->pview, &done, &total);
+        bmutex_lock(data->mutex);
+        data->done = done;
+        data->total = total;
+        cancel = data->cancel;
+        bmutex_unlock(data->mutex);
     }
+    return cancel ? ktRUN_CANCEL : ktRUN_COMPLETE;
+}
+
+/*---------------------------------------------------------------------------*/
 
-    if (button_get_state(app->tail) == ekGUI_ON)
+static void i_parse_update(Pdata *data)
+{
+    uint32_t done, total;
+    bmutex_lock(data->mutex);
+    done = data->done;
+    total = data->total;
+    bmutex_unlock(data->mutex);
+    if (total > 0 && data->cancel == FALSE)
     {
-        textview_scroll_caret(app->cmdout);
-        textview_scroll_caret(app->cmderr);
+        char_t text[64];
+        bstd_sprintf(text, sizeof(text), "%s %d%%", st_parsing, (uint32_t)((uint64_t)done * 100 / total));
+        label_text(data->app->status, text);
     }
 
-    if (read0 && out != ekPAGAIN && err != ekPAGAIN)
+    i_audit_text(data->app);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_run_finish(App *app);
+
+static void i_parse_end(Pdata *data, const uint32_t rval)
+{
+    App *app = data->app;
+    app->pdata = NULL;
+    if (rval == ktRUN_COMPLETE && data->pview != NULL && !app->closing)
+        populate_views(app, &data->pview);
+    else if (data->pview != NULL)
+        pview_destroy(&data->pview);
+
+    app->run_state = (run_t)rval;
+    bmutex_close(&data->mutex);
+    heap_delete(&data, Pdata);
+    if (app->closing)
+        osapp_finish();
+    else
+        i_run_finish(app);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* posted by i_parse_start like i_OnPage, a stop or a close before it only makes the task return early */
+static void i_OnParse(App *app, Event *e)
+{
+    cassert_no_null(app->pdata);
+    osapp_task(app->pdata, READ_UPDATE_TIME, bg_parse_main, i_parse_update, i_parse_end, Pdata);
+    unref(e);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_parse_start(App *app)
+{
+    Pdata *data = heap_new0(Pdata);
+    data->app = app;
+    data->mutex = bmutex_create();
+    app->pdata = data;
+    label_text(app->status, st_parsing);
+    gui_OnIdle(listener(app, i_OnParse, App));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the views aren't built, the run ends as stopped */
+static void i_parse_cancel(App *app)
+{
+    if (app->pdata)
     {
-        bproc_close(&app->proc);
-        app->run_state = ktRUN_COMPLETE;
+        bmutex_lock(app->pdata->mutex);
+        app->pdata->cancel = TRUE;
+        bmutex_unlock(app->pdata->mutex);
     }
 }
 
@@ -262,28 +614,54 @@ static void i_run_update(App *app)
 
 static void i_run_end(App *app, const uint32_t rval)
 {
-    /* reset state */
-    if (app->replace_line)
+    /* 119 is empty resource list */
+    bool_t captured;
+    /* whatever the reader got after the last update */
+    i_run_drain(app, UINT32_MAX, NULL);
+    i_run_tail(app);
+    refresh_table(app);
+    if (app->proc)
+        kproc_close(&app->proc);
+    app->run_state = (run_t)rval;
+    captured = app->out_len - app->page_off > 119 && spool_len(app->spool) == app->out_len - app->page_off;
+
+    /* the run goes on with the next page */
+    if (app->run_state == ktRUN_COMPLETE && captured && app->page_path && i_run_page(app))
+        return;
+
+    /* or with the parse, the last page of a paged list is already populated */
+    if (app->run_state == ktRUN_COMPLETE && captured && !app->page_path)
     {
-        arrst_clear(app->pos_lens, NULL, line_pos);
-        setst_destroy(&app->dict, NULL, line);
+        i_parse_start(app);
+        return;
     }
+
+    i_run_finish(app);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_run_finish(App *app)
+{
+    /* reset state */
+    if (app->replace_line)
+        keymap_destroy(&app->dict);
     edit_editable(app->cmdin, TRUE);
     cell_enabled(app->nolimitb, TRUE);
     cell_enabled(app->replace, TRUE);
     button_text(app->run, bt_run);
-    app->stop = FALSE;
-    if (app->run_state == ktRUN_COMPLETE)
+    if (app->run_state == ktRUN_COMPLETE && app->code != 0 && app->code != UINT32_MAX)
+    {
+        char_t text[64];
+        bstd_sprintf(text, sizeof(text), "%s %u", st_exited, app->code);
+        label_text(app->status, text);
+        app->run_state = ktRUN_ENDED;
+    }
+    else if (app->run_state == ktRUN_COMPLETE)
     {
         label_text(app->status, st_completed);
         app->run_state = ktRUN_ENDED;
-        /* 119 is empty resource list */
-        if (app->out_len > 119 && (app->nolimit || app->out_len < INITIAL_PARSE_SIZE))
-        {
-            populate_views(app);
-        }
     }
-
     else if (app->run_state == ktRUN_CANCEL)
     {
         label_text(app->status, st_stopped);
@@ -293,7 +671,16 @@ static void i_run_end(App *app, const uint32_t rval)
     {
         label_text(app->status, st_unknown);
     }
-    unref(rval);
+
+    if (app->run_state == ktRUN_ENDED && app->out_len >= INDEX_MIN_SIZE)
+        gui_OnIdle(listener(app, i_OnIndex, App));
+
+    /* views parse the capture in place and keep using it, otherwise it's not needed anymore */
+    if (arrpt_size(app->views, Destroyer) == 0)
+    {
+        scanner_reset(app->scanner);
+        spool_reset(app->spool);
+    }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -307,6 +694,396 @@ static void viewdata_destroy(Destroyer **destr)
 
 /*---------------------------------------------------------------------------*/
 
+/* one search over stdout or stderr, owned by its task */
+struct _sdata_t
+{
+    App *app;
+    Mutex *mutex;
+    /* stderr kept by the app, or the log view when NULL */
+    const byte_t *text;
+    uint32_t len;
+    const LogView *view;
+    uint32_t from;
+    /* regex mode when not NULL */
+    RegEx *re;
+    byte_t *pattern;
+    uint32_t plen;
+    /* start, length pairs */
+    ArrSt(uint32_t) *found;
+    /* starts of a shorter pattern to narrow, scans the source when NULL */
+    ArrSt(uint32_t) *narrow;
+    /* every start of a literal pattern, overlapping, NULL past SEARCH_CANDS */
+    ArrSt(uint32_t) *cands;
+    /* stdout index and the starts of the lines it can't rule out, filled on the task */
+    const Trigram *index;
+    ArrSt(uint32_t) *lines;
+    bool_t cancel;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* selects a match of the search, UINT32_MAX clears the selection */
+static void i_search_show(App *app, const uint32_t start, const uint32_t len)
+{
+    if (button_get_state(app->err_search) == ekGUI_ON)
+    {
+        if (start == UINT32_MAX)
+        {
+            textview_select(app->cmderr, -1, -1);
+        }
+        else
+        {
+            /* the text view counts characters */
+            uint32_t st = i_last_chars(app->err_text, 0, app->err_len, MAX_ERR_SIZE);
+            uint32_t cst = i_count_chars(app->err_text, st, start);
+            uint32_t ced = cst + i_count_chars(app->err_text, start, start + len);
+            textview_select(app->cmderr, (int32_t)cst, (int32_t)ced);
+            textview_scroll_caret(app->cmderr);
+        }
+    }
+    else
+    {
+        if (start == UINT32_MAX)
+        {
+            logview_select(app->cmdout, -1, -1);
+        }
+        else
+        {
+            logview_select(app->cmdout, (int32_t)start, (int32_t)(start + len));
+            logview_scroll_caret(app->cmdout);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* current match and the count, with an ellipsis while the task is still looking */
+static void i_search_status(App *app)
+{
+    char_t text[64];
+    uint32_t n = arrst_size(app->pos_cache, uint32_t) / 2;
+    bstd_sprintf(text, sizeof(text), st_search, n ? app->cur_idx + 1 : 0, n, app->sdata ? "…" : "");
+    label_text(app->status, text);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* text from offset to the end of the line (stdout) or of the buffer (stderr), NULL past the end */
+static const byte_t *i_search_span(const Sdata *data, const uint32_t offset, uint32_t *len)
+{
+    if (data->text)
+    {
+        if (offset >= data->len)
+            return NULL;
+        *len = data->len - offset;
+        return data->text + offset;
+    }
+    return cast_const(logview_text(data->view, offset, len), byte_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* a literal match at start, shown if it begins at or after clear, kept to narrow in any case */
+static void i_search_add(Sdata *data, const uint32_t start, uint32_t *clear)
+{
+    if (start >= *clear)
+    {
+        arrst_append(data->found, start, uint32_t);
+        arrst_append(data->found, data->plen, uint32_t);
+        *clear = start + data->plen;
+    }
+
+    if (data->cands != NULL)
+    {
+        if (arrst_size(data->cands, uint32_t) < SEARCH_CANDS)
+            arrst_append(data->cands, start, uint32_t);
+        else
+            arrst_destroy(&data->cands, NULL, uint32_t);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* keeps the starts of the shorter pattern that still match, the longer one can't match anywhere else */
+static bool_t i_search_narrow(Sdata *data, uint32_t *idx, uint32_t *clear)
+{
+    uint32_t n = arrst_size(data->narrow, uint32_t);
+    uint32_t scanned = 0;
+    while (*idx < n && scanned < SEARCH_SLICE)
+    {
+        uint32_t start = *arrst_get_const(data->narrow, *idx, uint32_t);
+        uint32_t len = 0;
+        const byte_t *text = i_search_span(data, start, &len);
+        if (text != NULL && len >= data->plen && bmem_cmp(text, data->pattern, data->plen) == 0)
+            i_search_add(data, start, clear);
+        scanned += data->plen;
+        *idx += 1;
+    }
+    return *idx < n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* only the lines that have every trigram of the pattern */
+static bool_t i_search_lines(Sdata *data, uint32_t *idx, uint32_t *clear)
+{
+    uint32_t n, scanned = 0;
+    if (data->lines == NULL)
+    {
+        data->lines = arrst_create(uint32_t);
+        trigram_lines(data->index, data->pattern, data->plen, data->lines);
+    }
+
+    n = arrst_size(data->lines, uint32_t);
+    while (*idx < n && scanned < SEARCH_SLICE)
+    {
+        uint32_t start = *arrst_get_const(data->lines, *idx, uint32_t);
+        uint32_t len = 0, off = 0, next;
+        const byte_t *text = i_search_span(data, start, &len);
+        if (text != NULL)
+        {
+            while ((next = find_bytes(text + off, len - off, data->pattern, data->plen)) != UINT32_MAX)
+            {
+                i_search_add(data, start + off + next, clear);
+                off += next + 1;
+            }
+        }
+        scanned += len + 1;
+        *idx += 1;
+    }
+    return *idx < n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* one slice of the source, FALSE at its end */
+static bool_t i_search_scan(Sdata *data, uint32_t *from, uint32_t *clear)
+{
+    uint32_t scanned = 0;
+    while (scanned < SEARCH_SLICE)
+    {
+        uint32_t len = 0, mlen = 0, next;
+        const byte_t *text = i_search_span(data, *from, &len);
+        if (text == NULL)
+            return FALSE;
+
+        if (data->re != NULL)
+            next = regex_find(data->re, cast_const(text, char_t), len, 0, &mlen);
+        else
+            next = find_bytes(text, len, data->pattern, data->plen);
+
+        if (next == UINT32_MAX)
+        {
+            /* the rest of the line and its newline */
+            *from += len + 1;
+            scanned += len + 1;
+        }
+        else if (data->re != NULL)
+        {
+            /* regex matches are never empty */
+            arrst_append(data->found, *from + next, uint32_t);
+            arrst_append(data->found, mlen, uint32_t);
+            *from += next + mlen;
+            scanned += next + mlen;
+        }
+        else
+        {
+            i_search_add(data, *from + next, clear);
+            *from += next + 1;
+            scanned += next + 1;
+        }
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ finds every match on the task thread. nothing writes to the output while no
+ command runs, the source is only read with the mutex held so that once a
+ cancel is set under it the task doesn't touch the source anymore
+*/
+static uint32_t bg_search_main(Sdata *data)
+{
+    uint32_t from = data->from, idx = 0, clear = 0;
+    bool_t more = TRUE;
+    while (more)
+    {
+        bmutex_lock(data->mutex);
+        if (data->cancel == TRUE)
+            more = FALSE;
+        else if (data->narrow != NULL)
+            more = i_search_narrow(data, &idx, &clear);
+        else if (data->index != NULL)
+            more = i_search_lines(data, &idx, &clear);
+        else
+            more = i_search_scan(data, &from, &clear);
+        bmutex_unlock(data->mutex);
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* new matches go to the cache, the first one is shown as soon as it's found */
+static void i_search_update(Sdata *data)
+{
+    App *app = data->app;
+    uint32_t i, n, shown;
+    if (data->cancel == TRUE)
+        return;
+
+    shown = arrst_size(app->pos_cache, uint32_t);
+    bmutex_lock(data->mutex);
+    n = arrst_size(data->found, uint32_t);
+    for (i = shown; i < n; ++i)
+        arrst_append(app->pos_cache, *arrst_get_const(data->found, i, uint32_t), uint32_t);
+    bmutex_unlock(data->mutex);
+
+    if (shown == 0 && n > 0)
+    {
+        const uint32_t *match = arrst_get_const(app->pos_cache, 0, uint32_t);
+        i_search_show(app, match[0], match[1]);
+    }
+    i_search_status(app);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_sdata_destroy(Sdata **data)
+{
+    if ((*data)->re != NULL)
+        regex_destroy(&(*data)->re);
+    if ((*data)->narrow != NULL)
+        arrst_destroy(&(*data)->narrow, NULL, uint32_t);
+    if ((*data)->cands != NULL)
+        arrst_destroy(&(*data)->cands, NULL, uint32_t);
+    if ((*data)->lines != NULL)
+        arrst_destroy(&(*data)->lines, NULL, uint32_t);
+    if ((*data)->pattern != NULL)
+        heap_delete_n(&(*data)->pattern, (*data)->plen, byte_t);
+    arrst_destroy(&(*data)->found, NULL, uint32_t);
+    bmutex_close(&(*data)->mutex);
+    heap_delete(data, Sdata);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_search_end(Sdata *data, const uint32_t rval)
+{
+    if (data->cancel == FALSE)
+    {
+        App *app = data->app;
+        app->sdata = NULL;
+        i_search_update(data);
+        if (data->cands != NULL)
+        {
+            /* complete, the next keystroke narrows it */
+            app->cands = data->cands;
+            app->cand_pat = data->pattern;
+            app->cand_plen = data->plen;
+            data->cands = NULL;
+            data->pattern = NULL;
+        }
+    }
+    i_sdata_destroy(&data);
+    unref(rval);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the task stops reading the output before this returns and frees itself later */
+static void i_search_cancel(App *app)
+{
+    if (app->sdata)
+    {
+        bmutex_lock(app->sdata->mutex);
+        app->sdata->cancel = TRUE;
+        bmutex_unlock(app->sdata->mutex);
+        app->sdata = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the output or the search mode changed, the next search scans again */
+static void i_search_forget(App *app)
+{
+    if (app->cands != NULL)
+    {
+        arrst_destroy(&app->cands, NULL, uint32_t);
+        heap_delete_n(&app->cand_pat, app->cand_plen, byte_t);
+        app->cand_plen = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_search_start(App *app, const char_t *pattern)
+{
+    Sdata *data;
+    RegEx *re = NULL;
+    uint32_t plen = str_len_c(pattern);
+    i_search_cancel(app);
+    i_search_show(app, UINT32_MAX, 0);
+    arrst_clear(app->pos_cache, NULL, uint32_t);
+    app->cur_idx = 0;
+    if (plen == 0)
+        return;
+
+    if (button_get_state(app->regex) == ekGUI_ON)
+    {
+        re = regex_create(pattern);
+        if (re == NULL)
+        {
+            label_text(app->status, st_bad_regex);
+            return;
+        }
+    }
+
+    data = heap_new0(Sdata);
+    data->app = app;
+    data->mutex = bmutex_create();
+    data->found = arrst_create(uint32_t);
+    data->re = re;
+    data->pattern = heap_new_n(plen, byte_t);
+    data->plen = plen;
+    bmem_copy(data->pattern, cast_const(pattern, byte_t), plen);
+    if (re == NULL)
+    {
+        /* the pattern grew at its end, only where the shorter one matched */
+        if (app->cands != NULL && plen >= app->cand_plen && bmem_cmp(data->pattern, app->cand_pat, app->cand_plen) == 0)
+        {
+            data->narrow = app->cands;
+            app->cands = NULL;
+            heap_delete_n(&app->cand_pat, app->cand_plen, byte_t);
+            app->cand_plen = 0;
+        }
+        data->cands = arrst_create(uint32_t);
+    }
+    i_search_forget(app);
+    if (button_get_state(app->err_search) == ekGUI_ON)
+    {
+        /* only what the view still shows */
+        data->text = app->err_text;
+        data->len = app->err_len;
+        data->from = i_last_chars(app->err_text, 0, app->err_len, MAX_ERR_SIZE);
+    }
+    else
+    {
+        data->view = app->cmdout;
+        /* a narrowed search already has fewer places to look */
+        if (re == NULL && data->narrow == NULL && plen >= 3)
+            data->index = app->index;
+    }
+
+    app->sdata = data;
+    i_search_status(app);
+    osapp_task(data, READ_UPDATE_TIME, bg_search_main, i_search_update, i_search_end, Sdata);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_OnRun(App *app, Event *e)
 {
     if (app->run_state == ktRUN_ENDED)
@@ -316,13 +1093,19 @@ static void i_OnRun(App *app, Event *e)
         cmdin = edit_get_text(app->cmdin);
 
         label_text(app->status, st_ready);
-        app->start_ptr = NULL;
-        app->pat_len = 0;
+        /* the output is about to change under the search task */
+        i_search_cancel(app);
+        i_search_forget(app);
+        i_index_forget(app);
+        arrst_clear(app->pos_cache, NULL, uint32_t);
         app->out_len = 0;
         app->err_len = 0;
+        app->err_new = 0;
         edit_text(app->search, "");
-        textview_clear(app->cmdout);
+        logview_hint(app->cmdout, NULL);
+        logview_clear(app->cmdout);
         textview_clear(app->cmderr);
+        i_audit_text(app);
 
         popup_selected(app->vselect, 0);
         layout_show_row(app->vscroll, 0, TRUE);
@@ -342,6 +1125,14 @@ static void i_OnRun(App *app, Event *e)
             yyjson_mut_doc_free(app->doc);
             app->doc = NULL;
         }
+        app->table = NULL;
+        str_destopt(&app->page_path);
+        app->page_off = 0;
+        scanner_reset(app->scanner);
+        spool_reset(app->spool);
+        watch_reset(app->watch);
+        /* every doc of the last run is gone */
+        alc_reset(app->alc);
 
         if (cmdin && cmdin[0])
         {
@@ -354,25 +1145,17 @@ static void i_OnRun(App *app, Event *e)
             bmem_copy(bmatch, cast(cmdin, byte_t), len);
             bmatch[len] = '\0';
 
-            app->proc = bproc_exec(cast(bmatch, char_t), NULL);
-            app->run_state = ktRUN_INPROGRESS;
-            edit_editable(app->cmdin, FALSE);
-            cell_enabled(app->nolimitb, FALSE);
-            cell_enabled(app->replace, FALSE);
-            label_text(app->status, st_running);
-            bproc_write_close(app->proc);
-            button_text(app->run, bt_stop);
-            if (app->replace_line)
-            {
-                app->line_num = 0;
-                app->dict = setst_create(line_cmp, line, line);
-            }
-            osapp_task(app, 0., bg_proc_main, i_run_update, i_run_end, App);
+            if (kapi_paged(cast(bmatch, char_t)))
+                app->page_path = str_c(cast(bmatch, char_t));
+            i_run_start(app, cast(bmatch, char_t));
         }
     }
     else
     {
-        app->stop = TRUE;
+        reader_stop(app->reader);
+        i_parse_cancel(app);
+        /* between two pages, the next one isn't fetched */
+        str_destopt(&app->page_next);
         label_text(app->status, st_stopping);
     }
     unref(e);
@@ -388,7 +1171,7 @@ static void i_OnWrap(App *app, Event *e)
         return;
     }
     p = event_params(e, EvButton);
-    textview_wrap(app->cmdout, p->state == ekGUI_ON ? TRUE : FALSE);
+    logview_wrap(app->cmdout, p->state == ekGUI_ON ? TRUE : FALSE);
     textview_wrap(app->cmderr, p->state == ekGUI_ON ? TRUE : FALSE);
 }
 
@@ -396,10 +1179,13 @@ static void i_OnWrap(App *app, Event *e)
 
 static void i_ResetSearch(App *app, Event *e)
 {
-    app->start_ptr = NULL;
+    i_search_cancel(app);
+    i_search_forget(app);
     arrst_clear(app->pos_cache, NULL, uint32_t);
-    textview_select(app->cmdout, -1, -1);
+    logview_select(app->cmdout, -1, -1);
     textview_select(app->cmderr, -1, -1);
+    if (app->run_state == ktRUN_ENDED)
+        i_search_start(app, edit_get_text(app->search));
     unref(e);
 }
 
@@ -413,69 +1199,34 @@ static void i_NoSizeLimit(App *app, Event *e)
 
 /*---------------------------------------------------------------------------*/
 
+/* every match is known or being found, moving is a lookup in the cache */
 static void i_OnSearchUpDown(App *app, Event *e)
 {
-    const EvButton *p;
-    TextView *tview;
-    if (!app->start_ptr)
+    const EvButton *p = event_params(e, EvButton);
+    const uint32_t *match = NULL;
+    uint32_t n = arrst_size(app->pos_cache, uint32_t) / 2;
+    if (n == 0)
         return;
 
-    tview = button_get_state(app->err_search) == ekGUI_ON
-                ? app->cmderr
-                : app->cmdout;
-
-    p = event_params(e, EvButton);
+    /* wraps around once the count is final */
     if (p->index == 0)
     {
-        /* current index should be b/n 0 and max index if already found */
         if (app->cur_idx != 0)
             app->cur_idx -= 1;
-        else if (app->end_len)
-            app->cur_idx = app->end_len - 1;
+        else if (app->sdata == NULL)
+            app->cur_idx = n - 1;
     }
     else
     {
-        app->cur_idx += 1;
-        if (app->cur_idx == app->end_len)
+        if (app->cur_idx + 1 < n)
+            app->cur_idx += 1;
+        else if (app->sdata == NULL)
             app->cur_idx = 0;
     }
 
-    if (arrst_size(app->pos_cache, uint32_t) > app->cur_idx)
-    {
-        /* getting from cache */
-        int32_t start = *arrst_get_const(app->pos_cache, app->cur_idx, uint32_t);
-        textview_select(tview, start, start + app->pat_len);
-        textview_scroll_caret(tview);
-    }
-    else
-    {
-        char *next = blib_strstr(app->start_ptr, edit_get_text(app->search));
-        if (next)
-        {
-            int32_t start;
-            uint32_t offset = next - app->start_ptr;
-
-            int32_t prev = *arrst_get_const(app->pos_cache, app->cur_idx - 1, uint32_t);
-            arrst_append(app->pos_cache, prev + app->pat_len + offset, uint32_t);
-
-            start = prev + app->pat_len + offset;
-            textview_select(tview, start, start + app->pat_len);
-            textview_scroll_caret(tview);
-
-            app->start_ptr = next + (sizeof(char_t) * app->pat_len);
-        }
-        else
-        {
-            int32_t start;
-            app->end_len = app->cur_idx;
-            app->cur_idx = 0;
-
-            /* getting from cache */
-            start = *arrst_get_const(app->pos_cache, app->cur_idx, uint32_t);
-            textview_select(tview, start, start + app->pat_len);
-            textview_scroll_caret(tview);
-        }
-    }
+    match = arrst_get_const(app->pos_cache, 2 * app->cur_idx, uint32_t);
+    i_search_show(app, match[0], match[1]);
+    i_search_status(app);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -491,49 +1242,10 @@ static void i_focus_search(App *app, Event *e)
 static void i_OnSearchFilter(App *app, Event *e)
 {
     const EvText *p = event_params(e, EvText);
-    TextView *tview;
     if (app->run_state != ktRUN_ENDED)
         return;
 
-    tview = button_get_state(app->err_search) == ekGUI_ON
-                ? app->cmderr
-                : app->cmdout;
-
-    app->pat_len += p->len;
-    if (app->pat_len == 0)
-    {
-        /* reset starter and cache */
-        app->start_ptr = NULL;
-        arrst_clear(app->pos_cache, NULL, uint32_t);
-        textview_select(tview, -1, -1);
-    }
-    else
-    {
-        char *first;
-        /* TODO: possible to replace with Boyer–Moore or Efficient BNDM? */
-        app->start_ptr = textview_get_text(tview);
-        first = blib_strstr(app->start_ptr, p->text);
-        if (first)
-        {
-            uint32_t offset = first - app->start_ptr;
-
-            arrst_clear(app->pos_cache, NULL, uint32_t);
-            arrst_append(app->pos_cache, offset, uint32_t);
-            app->cur_idx = 0;
-
-            textview_select(tview, offset, offset + app->pat_len);
-            textview_scroll_caret(tview);
-
-            app->start_ptr = first + (sizeof(char_t) * app->pat_len);
-        }
-        else
-        {
-            /* reset starter and cache */
-            app->start_ptr = NULL;
-            arrst_clear(app->pos_cache, NULL, uint32_t);
-            textview_select(tview, -1, -1);
-        }
-    }
+    i_search_start(app, p->text);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -586,6 +1298,22 @@ static void i_OnComplete(App *app, Event *e)
 
 /*---------------------------------------------------------------------------*/
 
+/* live and peak KiB of what kutes allocates on its own, by kind */
+static void i_OnStatus(App *app, Event *e)
+{
+    MemStat stats[ktMEM_COUNT];
+    char_t text[128];
+    unref(e);
+    audit_read(stats);
+    bstd_sprintf(text, sizeof(text), "yyjson %u/%u KiB, boron %u/%u KiB, text %u/%u KiB",
+                 (uint32_t)(stats[ktMEM_YYJSON].live / 1024), (uint32_t)(stats[ktMEM_YYJSON].peak / 1024),
+                 (uint32_t)(stats[ktMEM_BORON].live / 1024), (uint32_t)(stats[ktMEM_BORON].peak / 1024),
+                 (uint32_t)(stats[ktMEM_TEXT].live / 1024), (uint32_t)(stats[ktMEM_TEXT].peak / 1024));
+    label_text(app->status, text);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_OnInvert(App *app, Event *e)
 {
 #if defined(__LINUX__)
@@ -619,16 +1347,17 @@ static Panel *i_panel(App *app)
     Button *complete = button_check();
 
     Layout *result = layout_create(1, 2);
-    Layout *ops = layout_create(7, 1);
+    Layout *ops = layout_create(8, 1);
     Button *wrap = button_check();
     Button *tail = button_check();
     Edit *search = edit_create();
     Button *err_search = button_check();
+    Button *regex = button_check();
     Button *noshow = button_check();
     Button *nolimitb = button_check();
     UpDown *searchUpdown = updown_create();
     SplitView *hsplit = splitview_horizontal();
-    TextView *cmdout = textview_create();
+    LogView *cmdout = logview_create();
     TextView *cmderr = textview_create();
 
     Label *status = label_create();
@@ -706,25 +1435,27 @@ static Panel *i_panel(App *app)
 
     layout_button(ops, err_search, 4, 0);
 
+    button_text(regex, bt_regex);
+    button_OnClick(regex, listener(app, i_ResetSearch, App));
+    button_state(regex, ekGUI_OFF);
+
+    layout_button(ops, regex, 5, 0);
+
     button_text(noshow, "noshow");
     button_state(noshow, ekGUI_OFF);
 
-    layout_button(ops, noshow, 5, 0);
+    layout_button(ops, noshow, 6, 0);
 
     button_text(nolimitb, "nolimit");
     button_OnClick(nolimitb, listener(app, i_NoSizeLimit, App));
     button_state(nolimitb, ekGUI_OFF);
 
-    layout_button(ops, nolimitb, 6, 0);
+    layout_button(ops, nolimitb, 7, 0);
 
     layout_layout(result, ops, 0, 0);
 
-    textview_show_select(cmdout, TRUE);
-    textview_wrap(cmdout, FALSE);
-    textview_fstyle(cmdout, ekFITALIC);
-    textview_writef(cmdout, info);
-    textview_fstyle(cmdout, ekFNORMAL);
-    splitview_text(hsplit, cmdout, FALSE);
+    logview_hint(cmdout, info);
+    splitview_view(hsplit, cast(cmdout, View), FALSE);
 
     textview_color(cmderr, kCOLOR_RED);
     textview_show_select(cmderr, TRUE);
@@ -744,6 +1475,7 @@ static Panel *i_panel(App *app)
     layout_vexpand(main, 1);
 
     label_text(status, st_ready);
+    label_OnClick(status, listener(app, i_OnStatus, App));
     layout_halign(state, 0, 0, ekJUSTIFY);
 
     layout_label(state, status, 0, 0);
@@ -767,8 +1499,9 @@ static Panel *i_panel(App *app)
     app->tail = tail;
     app->search = search;
     app->err_search = err_search;
+    app->regex = regex;
     app->noshow = noshow;
-    app->nolimitb = layout_cell(ops, 6, 0);
+    app->nolimitb = layout_cell(ops, 7, 0);
     app->cmdout = cmdout;
     app->cmderr = cmderr;
     app->status = status;
@@ -785,10 +1518,16 @@ static void i_OnClose(App *app, Event *e)
 {
     if (app->proc)
     {
-        bproc_cancel(app->proc);
-        bproc_close(&app->proc);
+        /* reader cancels the process, proc can't be closed under it */
+        reader_cancel(app->reader);
+        kproc_close(&app->proc);
     }
-    osapp_finish();
+    i_parse_cancel(app);
+    /* the doc and pview_create can't be cancelled, they use what i_destroy frees */
+    if (app->pdata)
+        app->closing = TRUE;
+    else
+        osapp_finish();
     unref(e);
 }
 
@@ -813,14 +1552,24 @@ static App *i_create(void)
     app->hist = history_load();
     app->complete = TRUE;
     app->pos_cache = arrst_create(uint32_t);
+    app->err_text = heap_new_n(ERR_KEEP + 1, byte_t);
+    app->framer = framer_create();
+    app->out_utf8 = utf8_create();
+    app->err_utf8 = utf8_create();
     app->run_state = ktRUN_ENDED;
-    app->alc = alc_init("yyjson");
-    app->parse_size = INITIAL_PARSE_SIZE + READ_BUFFER + YYJSON_PADDING_SIZE;
-    app->parse_buf = heap_new_n(app->parse_size, byte_t);
+    app->alc = alc_init("yyjson", ktMEM_YYJSON);
+    app->reader = reader_create();
+#if defined(__UNIX__)
+    /* the shell, filter commands and sockets can go away while we write to them, EPIPE is handled where it's written */
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    app->shell = kshell_create();
+    app->spool = spool_create();
+    app->scanner = scanner_create(app->alc);
+    app->watch = watch_create(app->alc);
     app->nolimit = FALSE;
     app->doc = NULL;
     app->views = arrpt_create(Destroyer);
-    app->pos_lens = arrst_create(line_pos);
     cols_bind();
 
     window_panel(app->window, panel);
@@ -839,17 +1588,30 @@ static App *i_create(void)
 
 static void i_destroy(App **app)
 {
+    i_search_cancel(*app);
+    i_search_forget(*app);
+    i_index_forget(*app);
     if ((*app)->doc)
         yyjson_mut_doc_free((*app)->doc);
     if ((*app)->uthread)
         uthread_destroy(&(*app)->uthread);
     if ((*app)->dict)
-        setst_destroy(&(*app)->dict, NULL, line);
-    arrst_destroy(&(*app)->pos_lens, NULL, line_pos);
+        keymap_destroy(&(*app)->dict);
     history_flush(&(*app)->hist);
+    reader_destroy(&(*app)->reader);
+    if ((*app)->shell)
+        kshell_destroy(&(*app)->shell);
     arrpt_destroy(&(*app)->views, viewdata_destroy, Destroyer);
     arrst_destroy(&(*app)->pos_cache, NULL, uint32_t);
-    heap_delete_n(&(*app)->parse_buf, (*app)->parse_size, byte_t);
+    heap_delete_n(&(*app)->err_text, ERR_KEEP + 1, byte_t);
+    framer_destroy(&(*app)->framer);
+    utf8_destroy(&(*app)->out_utf8);
+    utf8_destroy(&(*app)->err_utf8);
+    spool_destroy(&(*app)->spool);
+    scanner_destroy(&(*app)->scanner);
+    watch_destroy(&(*app)->watch);
+    str_destopt(&(*app)->page_path);
+    str_destopt(&(*app)->page_next);
     window_destroy(&(*app)->window);
     alc_dest(&(*app)->alc);
     heap_delete(&(*app)->locker, opsv);
@@ -1,22 +1,40 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
 #include "kt.h"
 
 #include <yyjson.h>
 #include <nappgui.h>
 #include <inet/json.h>
+#include <rax.h>
 
 #include <time.h>
 
+#if defined(__LINUX__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 /* https://stackoverflow.com/a/17996915 */
 #define QUOTE(...) #__VA_ARGS__
 /* due to usage of 32 bitmask for headers and having limits doesn't hurt */
 #define MAX_COLS 32
 /* 65 is based on pod name length 64 + NULL byte */
 #define TEMP_STR_LEN 65
+/* replaced watch objects stay in the doc until this many (or a table worth) pile up */
+#define WATCH_STALE 1024
+/* rows of the first pass evaluated between two checks for a cancel */
+#define PVIEW_STEP 256
+/* first size of the string pool of a table */
+#define TB_POOL 4096
 
 /*---------------------------------------------------------------------------*/
 
 typedef struct _column_t Column;
 typedef struct _columns_t Columns;
+typedef struct _tb_col_t TbCol;
+typedef struct _tb_cell_t TbCell;
 typedef struct _tb_data_t Tbdata;
 typedef struct _ft_data_t Ftdata;
 
@@ -34,6 +52,28 @@ struct _columns_t
     ArrSt(Column) *cols;
 };
 
+/* cells of a column, only the array of the type of its first row is used */
+struct _tb_col_t
+{
+    KDataType type;
+    /* ktINT, ktJVAL as its length and ktTIM as epoch seconds */
+    ArrSt(int64_t) *ints;
+    ArrSt(real64_t) *nums;
+    ArrSt(bool_t) *bools;
+    /* offsets in the string pool, UINT32_MAX when unset */
+    ArrSt(uint32_t) *strs;
+};
+
+/* a value as evaluated, before it's stored in its column */
+struct _tb_cell_t
+{
+    KDataType type;
+    int64_t i;
+    real64_t r;
+    const char_t *str;
+    uint32_t len;
+};
+
 DeclPt(yyjson_mut_val);
 struct _tb_data_t
 {
@@ -47,19 +87,34 @@ struct _tb_data_t
     ArrSt(uint32_t) *widths;
     ArrPt(String) *expr;
     ArrPt(String) *display;
-    ArrSt(KDataType) *kttype;
-    ArrPt(yyjson_mut_val) *ele;
-    yyjson_mut_doc *wdoc;
-    yyjson_mut_val *wroot;
+    TbCol cols[MAX_COLS];
+    /* strings of the cells back to back, each one once */
+    Keymap *interned;
+    char_t *pool;
+    uint32_t pool_len;
+    uint32_t pool_size;
+    ArrPt(yyjson_mut_val) *rows;
+    yyjson_alc *alc;
     byte_t *rowbuf;
     UThread *uthread;
     RegEx *iso8601;
+    /* next item of the first pass */
+    yyjson_mut_arr_iter iter;
+    /* watch mode, row of every metadata.uid */
+    rax *uids;
     uint32_t ncols;
     uint32_t nrows;
     uint32_t hmask;
     uint32_t freeze;
+    uint32_t strow;
+    uint32_t edrow;
+    uint32_t stale;
     real32_t font_width;
+    bool_t dropped;
+    /* columns took the types of the first row */
+    bool_t typed;
     bool_t invalid;
+    bool_t redraw;
 };
 
 struct _ft_data_t
@@ -68,9 +123,20 @@ struct _ft_data_t
     Edit *cmdin;
     Button *jptr;
     Button *run;
+    /* linux, stdin from the memfd instead of a pipe */
+    Button *shared;
     TextView *tview;
     Label *status;
+    /* set by the task under mutex once the command started */
     Proc *proc;
+    Mutex *mutex;
+    /* command of the run and the doc written to its stdin, both for the task */
+    String *cmd;
+    char_t *json;
+    size_t json_len;
+    /* linux, the doc written once for every run of the view */
+    int memfd;
+    bool_t use_memfd;
     uint32_t rsize;
     run_t run_state;
     bool_t stop;
@@ -128,7 +194,7 @@ static const char_t *info = "\
 command is stopped if stdout/stderr exceeds 64 KiB.\n\n\
 if jsonpointer is checked, inprocess jsonpointer path search or expression evaluation is performed (faster).\n\n\
 suggested external json filtering programs are jq (C), dasel (Go), jsonquerylang (Javascript/Python).\n\n\
-UI will freeze if your first command (like 'sleep') doesn't drain it's stdin.\
+the document is written to stdin on its own thread, stop cancels the command and the writing.\
 ";
 
 /*---------------------------------------------------------------------------*/
@@ -179,84 +245,114 @@ static ___INLINE time_t ktimegm(struct tm const *t)
 
 /*---------------------------------------------------------------------------*/
 
-static uint32_t human_duration(const char_t *then, time_t now_s, char_t *buf, uint8_t size)
+/* seconds of an iso8601 UTC time, INT64_MIN if it isn't one */
+static int64_t i_epoch(const char_t *then)
 {
     struct tm then_br;
-    time_t then_s;
-    sscanf(then, "%d-%d-%dT%d:%d:%dZ",
-           &then_br.tm_year, &then_br.tm_mon, &then_br.tm_mday,
-           &then_br.tm_hour, &then_br.tm_min, &then_br.tm_sec);
+    if (sscanf(then, "%d-%d-%dT%d:%d:%dZ",
+               &then_br.tm_year, &then_br.tm_mon, &then_br.tm_mday,
+               &then_br.tm_hour, &then_br.tm_min, &then_br.tm_sec) != 6)
+        return INT64_MIN;
     then_br.tm_year -= 1900;
     then_br.tm_mon -= 1;
     then_br.tm_isdst = -1;
+    return (int64_t)ktimegm(&then_br);
+}
 
-    then_s = ktimegm(&then_br);
-    {
-        /* from k8s.io/apimachinery/pkg/util/duration */
-        /* TODO: refactor later */
-        uint64_t seconds = (uint64_t)difftime(now_s, then_s);
-        uint32_t minutes, hours;
-
-        if (seconds == 0)
-            return bstd_sprintf(buf, size, "0s");
-        else if (seconds < 60 * 2)
-            return bstd_sprintf(buf, size, "%lds", seconds);
+/*---------------------------------------------------------------------------*/
 
-        minutes = seconds / 60;
-        if (minutes < 10)
-        {
-            uint32_t s = seconds % 60;
-            if (s == 0)
-                return bstd_sprintf(buf, size, "%dm", minutes);
-            return bstd_sprintf(buf, size, "%dm%ds", minutes, s);
-        }
-        else if (minutes < 60 * 3)
+static uint32_t human_duration(const time_t then_s, time_t now_s, char_t *buf, uint8_t size)
+{
+    /* from k8s.io/apimachinery/pkg/util/duration */
+    /* TODO: refactor later */
+    uint64_t seconds = (uint64_t)difftime(now_s, then_s);
+    uint32_t minutes, hours;
+
+    if (seconds == 0)
+        return bstd_sprintf(buf, size, "0s");
+    else if (seconds < 60 * 2)
+        return bstd_sprintf(buf, size, "%lds", seconds);
+
+    minutes = seconds / 60;
+    if (minutes < 10)
+    {
+        uint32_t s = seconds % 60;
+        if (s == 0)
             return bstd_sprintf(buf, size, "%dm", minutes);
+        return bstd_sprintf(buf, size, "%dm%ds", minutes, s);
+    }
+    else if (minutes < 60 * 3)
+        return bstd_sprintf(buf, size, "%dm", minutes);
 
-        hours = seconds / (60 * 60);
-        if (hours < 8)
-        {
-            uint32_t m = (seconds / 60) % 60;
-            if (m == 0)
-                return bstd_sprintf(buf, size, "%dh", hours);
-            return bstd_sprintf(buf, size, "%dh%dm", hours, m);
-        }
-        else if (hours < 48)
+    hours = seconds / (60 * 60);
+    if (hours < 8)
+    {
+        uint32_t m = (seconds / 60) % 60;
+        if (m == 0)
             return bstd_sprintf(buf, size, "%dh", hours);
-        else if (hours < 24 * 8)
-        {
-            uint32_t h = hours % 24;
-            if (h == 0)
-                return bstd_sprintf(buf, size, "%dd", hours / 24);
-            return bstd_sprintf(buf, size, "%dd%dh", hours / 24, h);
-        }
-        else if (hours < 24 * 365 * 2)
+        return bstd_sprintf(buf, size, "%dh%dm", hours, m);
+    }
+    else if (hours < 48)
+        return bstd_sprintf(buf, size, "%dh", hours);
+    else if (hours < 24 * 8)
+    {
+        uint32_t h = hours % 24;
+        if (h == 0)
             return bstd_sprintf(buf, size, "%dd", hours / 24);
-        else if (hours < 24 * 365 * 8)
-        {
-            uint32_t dy = (hours / 24) % 365;
-            if (dy == 0)
-                return bstd_sprintf(buf, size, "%dy", hours / 24 / 365);
-            return bstd_sprintf(buf, size, "%dy%dd", hours / 24 / 365, dy);
-        }
+        return bstd_sprintf(buf, size, "%dd%dh", hours / 24, h);
+    }
+    else if (hours < 24 * 365 * 2)
+        return bstd_sprintf(buf, size, "%dd", hours / 24);
+    else if (hours < 24 * 365 * 8)
+    {
+        uint32_t dy = (hours / 24) % 365;
+        if (dy == 0)
+            return bstd_sprintf(buf, size, "%dy", hours / 24 / 365);
+        return bstd_sprintf(buf, size, "%dy%dd", hours / 24 / 365, dy);
+    }
+
+    return bstd_sprintf(buf, size, "%dy", hours / 24 / 365);
+}
+
+/*---------------------------------------------------------------------------*/
 
-        return bstd_sprintf(buf, size, "%dy", hours / 24 / 365);
+/* columns lose their cells and types, the next first row types them again */
+static void tb_uncols(Tbdata *data)
+{
+    uint32_t i;
+    for (i = 0; i < MAX_COLS; ++i)
+    {
+        TbCol *col = data->cols + i;
+        if (col->ints)
+            arrst_destroy(&col->ints, NULL, int64_t);
+        if (col->nums)
+            arrst_destroy(&col->nums, NULL, real64_t);
+        if (col->bools)
+            arrst_destroy(&col->bools, NULL, bool_t);
+        if (col->strs)
+            arrst_destroy(&col->strs, NULL, uint32_t);
+        col->type = ktUNK;
     }
+    data->typed = FALSE;
+    keymap_clear(data->interned);
+    data->pool_len = 0;
 }
 
 /*---------------------------------------------------------------------------*/
 
 static void tb_destroy(Tbdata **data)
 {
+    tb_uncols(*data);
+    keymap_destroy(&(*data)->interned);
+    heap_delete_n(&(*data)->pool, (*data)->pool_size, char_t);
     arrst_destroy(&(*data)->widths, NULL, uint32_t);
-    arrpt_destroy(&(*data)->ele, NULL, yyjson_mut_val);
+    arrpt_destroy(&(*data)->rows, NULL, yyjson_mut_val);
     arrpt_destroy(&(*data)->expr, str_destroy, String);
     arrpt_destroy(&(*data)->display, str_destroy, String);
-    arrst_destroy(&(*data)->kttype, NULL, KDataType);
     heap_delete_n(&(*data)->rowbuf, ((TEMP_STR_LEN + 1) * MAX_COLS), byte_t);
     regex_destroy(&(*data)->iso8601);
-    if ((*data)->wdoc)
-        yyjson_mut_doc_free((*data)->wdoc);
+    if ((*data)->uids)
+        raxFree((*data)->uids);
     heap_delete(data, Tbdata);
 }
 
@@ -274,13 +370,14 @@ static Tbdata *tb_create_destroy(Destroyer **destr, yyjson_alc *alc)
 {
     Tbdata *data = heap_new0(Tbdata);
     data->widths = arrst_create(uint32_t);
-    data->ele = arrpt_create(yyjson_mut_val);
+    data->rows = arrpt_create(yyjson_mut_val);
     data->expr = arrpt_create(String);
     data->display = arrpt_create(String);
-    data->kttype = arrst_create(KDataType);
+    data->interned = keymap_create();
+    data->pool_size = TB_POOL;
+    data->pool = heap_new_n(data->pool_size, char_t);
     data->rowbuf = heap_new_n((TEMP_STR_LEN + 1) * MAX_COLS, byte_t);
-    data->wdoc = yyjson_mut_doc_new(alc);
-    data->wroot = yyjson_mut_obj(data->wdoc);
+    data->alc = alc;
     /* no validation only for matching */
     data->iso8601 = regex_create("20[0-9][0-9]\\-[0-1][0-9]\\-[0-3][0-9]T[0-2][0-9]:[0-5][0-9]:[0-5][0-9]Z");
 
@@ -382,7 +479,6 @@ static void onCol_rem(Tbdata *data, Event *e)
     {
         arrpt_delete(data->display, selected - 1, str_destroy, String);
         arrpt_delete(data->expr, selected - 1, str_destroy, String);
-        arrst_delete(data->kttype, selected - 1, NULL, KDataType);
         arrst_delete(data->widths, 2 * (selected - 1), NULL, uint32_t); /* header */
         arrst_delete(data->widths, 2 * (selected - 1), NULL, uint32_t); /* row */
         data->ncols--;
@@ -495,124 +591,242 @@ static void onRow_open(Tbdata *data, Event *e)
 
 /*---------------------------------------------------------------------------*/
 
-static ___INLINE yyjson_mut_val *get_tb_value(Tbdata *data, uint32_t row, uint32_t col)
+/* interned copy of the string, its offset in the pool */
+static uint32_t tb_intern(Tbdata *data, const char_t *str, const uint32_t len)
 {
-    /*
-    1D to 2D: pos = x + width*y
-    2D to 1D: x = pos % width; y = pos / width;
-    */
-    return arrpt_get(data->ele, col + data->ncols * row, yyjson_mut_val);
+    uint32_t off = data->pool_len;
+    if (!keymap_insert(data->interned, cast_const(str, byte_t), len, &off))
+        return off;
+
+    if (data->pool_len + len + 1 > data->pool_size)
+    {
+        uint32_t size = data->pool_size;
+        while (data->pool_len + len + 1 > size)
+            size *= 2;
+        data->pool = heap_realloc_n(data->pool, data->pool_size, size, char_t);
+        data->pool_size = size;
+    }
+
+    bmem_copy(cast(data->pool + off, byte_t), cast_const(str, byte_t), len);
+    data->pool[off + len] = '\0';
+    data->pool_len += len + 1;
+    return off;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static void tb_cache(Tbdata *data)
+/* value of the expression for the item, a string is only valid until the next evaluation */
+static void tb_cell(Tbdata *data, yyjson_mut_val *val, const char_t *expr, TbCell *cell)
 {
-    size_t idx, max, wkey = 0;
-    yyjson_mut_val *val;
-    if (data->invalid)
+    cell->type = ktUNK;
+    if (expr && expr[0] == '/')
     {
-        /* TODO: optimize if there is a latency */
-        arrpt_clear(data->ele, NULL, yyjson_mut_val);
-        arrst_clear(data->kttype, NULL, KDataType);
-        yyjson_mut_arr_foreach(data->items, idx, max, val)
+        yyjson_mut_val *res = yyjson_mut_ptr_get(val, expr);
+        switch (yyjson_mut_get_tag(res))
         {
-            KDataType val_type = ktUNK;
-            arrpt_foreach_const(path, data->expr, String)
-                const char_t *expr = tc(path);
-                yyjson_mut_val *key, *res = NULL;
-                if (expr && expr[0] == '/')
-                {
-                    res = yyjson_mut_ptr_get(val, tc(path));
-                    switch (yyjson_mut_get_tag(res))
-                    {
-                    case YYJSON_TYPE_STR | YYJSON_SUBTYPE_NONE:
-                    case YYJSON_TYPE_STR | YYJSON_SUBTYPE_NOESC:
-                        val_type = ktSTR;
-                        break;
-                    case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_UINT:
-                    case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_SINT:
-                        val_type = ktINT;
-                        break;
-                    case YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_TRUE:
-                    case YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_FALSE:
-                        val_type = ktBOOL;
-                        break;
-                    case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL:
-                        val_type = ktNUM;
-                        break;
-                    case YYJSON_TYPE_ARR | YYJSON_SUBTYPE_NONE:
-                    case YYJSON_TYPE_OBJ | YYJSON_SUBTYPE_NONE:
-                        val_type = ktJVAL;
-                        break;
-                    case YYJSON_TYPE_RAW | YYJSON_SUBTYPE_NONE:
-                    case YYJSON_TYPE_NULL | YYJSON_SUBTYPE_NONE:
-                    default:
-                        val_type = ktUNK;
-                        break;
-                    }
-                    arrpt_append(data->ele, res, yyjson_mut_val);
-                }
-                else
-                {
-                    UCell *vcell;
-                    /* wkey is stringified element index */
-                    bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%ld", wkey);
-                    key = yyjson_mut_strcpy(data->wdoc, data->tempstr);
-                    update_jroot(data->uthread, val);
-                    switch (boron_eval(data->uthread, expr, &vcell))
-                    {
-                    case ktTIM:
-                    case ktSTR:
-                        bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", bn_str(data->uthread, vcell));
-                        res = yyjson_mut_strcpy(data->wdoc, data->tempstr);
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktSTR;
-                        break;
-                    case ktINT:
-                        res = yyjson_mut_int(data->wdoc, bn_int(vcell));
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktINT;
-                        break;
-                    case ktBOOL:
-                        res = yyjson_mut_bool(data->wdoc, bn_bool(vcell));
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktBOOL;
-                        break;
-                    case ktNUM:
-                        res = yyjson_mut_real(data->wdoc, bn_num(vcell));
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktNUM;
-                        break;
-                    case ktJVAL:
-                        res = bn_jval(data->uthread, vcell);
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktJVAL;
-                        break;
-                    case ktUNK:
-                        res = yyjson_mut_null(data->wdoc);
-                        yyjson_mut_obj_add(data->wroot, key, res);
-                        val_type = ktUNK;
-                        break;
-                    }
-                    arrpt_append(data->ele, res, yyjson_mut_val);
-                }
+        case YYJSON_TYPE_STR | YYJSON_SUBTYPE_NONE:
+        case YYJSON_TYPE_STR | YYJSON_SUBTYPE_NOESC:
+            cell->type = ktSTR;
+            cell->str = yyjson_mut_get_str(res);
+            cell->len = (uint32_t)yyjson_mut_get_len(res);
+            break;
+        case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_UINT:
+        case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_SINT:
+            cell->type = ktINT;
+            cell->i = yyjson_mut_get_sint(res);
+            break;
+        case YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_TRUE:
+        case YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_FALSE:
+            cell->type = ktBOOL;
+            cell->i = yyjson_mut_get_bool(res);
+            break;
+        case YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL:
+            cell->type = ktNUM;
+            cell->r = yyjson_mut_get_real(res);
+            break;
+        case YYJSON_TYPE_ARR | YYJSON_SUBTYPE_NONE:
+        case YYJSON_TYPE_OBJ | YYJSON_SUBTYPE_NONE:
+            cell->type = ktJVAL;
+            cell->i = (int64_t)yyjson_mut_get_len(res);
+            break;
+        case YYJSON_TYPE_RAW | YYJSON_SUBTYPE_NONE:
+        case YYJSON_TYPE_NULL | YYJSON_SUBTYPE_NONE:
+        default:
+            break;
+        }
+    }
+    else
+    {
+        UCell *vcell;
+        update_jroot(data->uthread, val);
+        switch (boron_eval(data->uthread, expr, &vcell))
+        {
+        case ktTIM:
+        case ktSTR:
+            cell->type = ktSTR;
+            cell->str = bn_str(data->uthread, vcell);
+            cell->len = (uint32_t)blib_strlen(cell->str);
+            break;
+        case ktINT:
+            cell->type = ktINT;
+            cell->i = bn_int(vcell);
+            break;
+        case ktBOOL:
+            cell->type = ktBOOL;
+            cell->i = bn_bool(vcell);
+            break;
+        case ktNUM:
+            cell->type = ktNUM;
+            cell->r = bn_num(vcell);
+            break;
+        case ktJVAL:
+            cell->type = ktJVAL;
+            cell->i = (int64_t)yyjson_mut_get_len(bn_jval(data->uthread, vcell));
+            break;
+        case ktUNK:
+            break;
+        }
+    }
 
-                if (res && val_type == ktSTR)
-                {
-                    uint32_t len = yyjson_mut_get_len(res);
-                    if (len == blib_strlen("2001-02-13T14:15:16Z"))
-                        if (regex_match(data->iso8601, yyjson_mut_get_str(res)))
-                            val_type = ktTIM;
-                }
+    /* only the first row types a column, the others are parsed as its type */
+    if (cell->type == ktSTR && !data->typed && cell->len == blib_strlen("2001-02-13T14:15:16Z"))
+        if (regex_match(data->iso8601, cell->str))
+            cell->type = ktTIM;
+}
 
-                /* TODO: a value may not be available for first item, needs a fix */
-                if (arrst_size(data->kttype, KDataType) < data->ncols)
-                    arrst_append(data->kttype, val_type, KDataType);
+/*---------------------------------------------------------------------------*/
 
-                wkey++;
-            arrpt_end()
-        }
+/* the column takes the type of the cell */
+static void tb_type(TbCol *col, const KDataType type)
+{
+    col->type = type;
+    switch (type)
+    {
+    case ktINT:
+    case ktTIM:
+    case ktJVAL:
+        col->ints = arrst_create(int64_t);
+        break;
+    case ktNUM:
+        col->nums = arrst_create(real64_t);
+        break;
+    case ktBOOL:
+        col->bools = arrst_create(bool_t);
+        break;
+    case ktSTR:
+        col->strs = arrst_create(uint32_t);
+        break;
+    case ktUNK:
+        break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* row is appended when it's the next one, a cell of another type is stored as the column's */
+static void tb_put(Tbdata *data, TbCol *col, const uint32_t row, const TbCell *cell)
+{
+    bool_t text = cell->type == ktSTR || cell->type == ktTIM;
+    switch (col->type)
+    {
+    case ktINT:
+    case ktJVAL:
+    case ktTIM:
+    {
+        int64_t v;
+        if (col->type == ktTIM)
+            v = text ? i_epoch(cell->str) : INT64_MIN;
+        else
+            v = cell->type == col->type ? cell->i : 0;
+        if (row == arrst_size(col->ints, int64_t))
+            arrst_append(col->ints, v, int64_t);
+        else
+            *arrst_get(col->ints, row, int64_t) = v;
+        break;
+    }
+    case ktNUM:
+    {
+        real64_t v = cell->type == ktNUM ? cell->r : cell->type == ktINT ? (real64_t)cell->i : 0;
+        if (row == arrst_size(col->nums, real64_t))
+            arrst_append(col->nums, v, real64_t);
+        else
+            *arrst_get(col->nums, row, real64_t) = v;
+        break;
+    }
+    case ktBOOL:
+    {
+        bool_t v = cell->type == ktBOOL && cell->i ? TRUE : FALSE;
+        if (row == arrst_size(col->bools, bool_t))
+            arrst_append(col->bools, v, bool_t);
+        else
+            *arrst_get(col->bools, row, bool_t) = v;
+        break;
+    }
+    case ktSTR:
+    {
+        uint32_t v = text ? tb_intern(data, cell->str, cell->len) : UINT32_MAX;
+        if (row == arrst_size(col->strs, uint32_t))
+            arrst_append(col->strs, v, uint32_t);
+        else
+            *arrst_get(col->strs, row, uint32_t) = v;
+        break;
+    }
+    case ktUNK:
+        break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* cells of the row are evaluated and stored, it's appended when it's the next one */
+static void tb_row(Tbdata *data, const uint32_t row)
+{
+    yyjson_mut_val *val = arrpt_get(data->rows, row, yyjson_mut_val);
+    uint32_t col = 0;
+    arrpt_foreach_const(path, data->expr, String)
+        TbCell cell;
+        tb_cell(data, val, tc(path), &cell);
+        if (!data->typed)
+            tb_type(data->cols + col, cell.type);
+        tb_put(data, data->cols + col, row, &cell);
+        col++;
+    arrpt_end()
+    data->typed = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void tb_uncache(Tbdata *data)
+{
+    tb_uncols(data);
+    arrpt_clear(data->rows, NULL, yyjson_mut_val);
+    yyjson_mut_arr_iter_init(data->items, &data->iter);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* evaluates up to n more rows, TRUE while some are left */
+static bool_t tb_cache_rows(Tbdata *data, const uint32_t n)
+{
+    yyjson_mut_val *val;
+    uint32_t i;
+    for (i = 0; i < n && (val = yyjson_mut_arr_iter_next(&data->iter)) != NULL; ++i)
+    {
+        arrpt_append(data->rows, val, yyjson_mut_val);
+        tb_row(data, arrpt_size(data->rows, yyjson_mut_val) - 1);
+    }
+    return yyjson_mut_arr_iter_has_next(&data->iter);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void tb_cache(Tbdata *data)
+{
+    if (data->invalid)
+    {
+        /* TODO: optimize if there is a latency */
+        tb_uncache(data);
+        tb_cache_rows(data, UINT32_MAX);
         data->invalid = FALSE;
     }
 }
@@ -629,38 +843,45 @@ static void tb_OnHeader(Tbdata *data, Event *e)
 
 static ___INLINE uint32_t fill_tempstr(Tbdata *data, uint32_t col, uint32_t row)
 {
-    const KDataType *kttype = arrst_get_const(data->kttype, col, KDataType);
+    const TbCol *column = data->cols + col;
     uint32_t len = 0;
-    switch (*kttype)
+    switch (column->type)
     {
     case ktBOOL:
-        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", yyjson_mut_get_bool(get_tb_value(data, row, col)) ? "true" : "false");
+        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", *arrst_get_const(column->bools, row, bool_t) ? "true" : "false");
         break;
     case ktINT:
-        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%ld", yyjson_mut_get_sint(get_tb_value(data, row, col)));
+    case ktJVAL:
+        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%ld", *arrst_get_const(column->ints, row, int64_t));
         break;
     case ktNUM:
-        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%.2f", yyjson_mut_get_num(get_tb_value(data, row, col)));
+        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%.2f", *arrst_get_const(column->nums, row, real64_t));
         break;
     case ktSTR:
-        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", yyjson_mut_get_str(get_tb_value(data, row, col)));
+    {
+        uint32_t off = *arrst_get_const(column->strs, row, uint32_t);
+        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", off != UINT32_MAX ? data->pool + off : "<unset>");
         break;
+    }
     case ktTIM:
     {
-        const char_t *str = yyjson_mut_get_str(get_tb_value(data, row, col));
-        if (data->hmask & (1 << col))
+        int64_t secs = *arrst_get_const(column->ints, row, int64_t);
+        time_t then = (time_t)secs;
+        if (secs == INT64_MIN)
+        {
+            len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", "<unset>");
+        }
+        else if (data->hmask & (1 << col))
         {
-            str_copy_c(data->tempstr, TEMP_STR_LEN, str);
-            len = strlen(str);
+            struct tm *t = gmtime(&then);
+            len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%04d-%02d-%02dT%02d:%02d:%02dZ",
+                               t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
         }
         else
             /* more likely */
-            len = human_duration(str, time(NULL), data->tempstr, TEMP_STR_LEN);
+            len = human_duration(then, time(NULL), data->tempstr, TEMP_STR_LEN);
         break;
     }
-    case ktJVAL:
-        len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%ld", yyjson_mut_get_len(get_tb_value(data, row, col)));
-        break;
     case ktUNK:
         len = bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", "<unset>");
         break;
@@ -690,7 +911,8 @@ static void tb_OnData(Tbdata *data, Event *e)
         const EvTbRect *rect = event_params(e, EvTbRect);
         /* TODO: revisit if processing all the json takes time and only process visible table */
         tb_cache(data);
-        unref(rect);
+        data->strow = rect->strow;
+        data->edrow = rect->edrow;
         break;
     }
     case ekGUI_EVENT_TBL_CELL:
@@ -757,7 +979,8 @@ static void tb_OnData(Tbdata *data, Event *e)
 
 /*---------------------------------------------------------------------------*/
 
-static Destroyer *add_list_to_layout(UThread *ut, PopUp *pop, Layout *vscroll, yyjson_mut_doc *doc, Label *status, yyjson_alc *alc)
+/* table of a list that matches the column profile or NULL, no widgets yet so it can be built on a task */
+static Destroyer *tb_profile(UThread *ut, yyjson_mut_doc *doc, yyjson_alc *alc)
 {
     yyjson_mut_val *items = yyjson_mut_doc_ptr_get(doc, "/items");
     yyjson_mut_val *first = yyjson_mut_ptr_get(items, "/0/kind");
@@ -775,150 +998,177 @@ static Destroyer *add_list_to_layout(UThread *ut, PopUp *pop, Layout *vscroll, y
             Columns *json = json_read(stm, NULL, Columns);
             if (json != NULL && !blib_strcmp(kind, tc(json->kind)))
             {
-                Tbdata *data;
+                Tbdata *data = tb_create_destroy(&destr, alc);
                 uint32_t hlen;
-                uint32_t vscroll_ridx = popup_count(pop);
-                Layout *table = layout_create(1, 2);
-                Layout *ops = layout_create(1, 4);
-                Layout *add_col = layout_create(3, 1);
-                Layout *rem_col = layout_create(2, 1);
-                Layout *query_col = layout_create(3, 1);
-                Layout *status_row = layout_create(2, 1);
-
-                Edit *disp_name = edit_create();
-                Edit *json_ppth = edit_create();
-                Button *col_add = button_push();
+                data->mdoc = doc;
+                data->items = items;
+                data->nrows = yyjson_mut_arr_size(items);
+                data->freeze = 0;
+                data->uthread = ut;
+                arrst_foreach_const(col, json->cols, Column)
+                    if (data->ncols == MAX_COLS)
+                    {
+                        data->dropped = TRUE;
+                        log_printf("columns more than %d are dropped", MAX_COLS);
+                        break;
+                    }
 
-                PopUp *col_name = popup_create();
-                Button *col_rem = button_push();
+                    hlen = max_u32(bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", tc(col->display)), 1);
+                    arrpt_append(data->expr, str_copy(col->expr), String);
+                    arrpt_append(data->display, str_copy(col->display), String);
+                    arrst_append(data->widths, min_u32(hlen, TEMP_STR_LEN), uint32_t);
+                    arrst_append(data->widths, 0, uint32_t);
+                    data->freeze = col->freeze ? data->ncols : data->freeze;
 
-                Edit *query_ppth = edit_create();
-                Button *query_run = button_push();
-                Edit *query_result = edit_create();
+                    data->ncols++;
+                arrst_end()
 
-                Edit *line = edit_create();
-                Button *open = button_push();
+                data->invalid = TRUE;
+            }
+            json_destroy(&json, Columns);
+            stm_close(&stm);
+        }
+    }
+    return destr;
+}
 
-                Font *font = font_system(font_regular_size(), 0);
-                TableView *tbview = tableview_create();
+/*---------------------------------------------------------------------------*/
 
-                edit_phstyle(disp_name, ekFITALIC);
-                edit_phtext(disp_name, "display name");
-                layout_edit(add_col, disp_name, 0, 0);
+/* widgets of the table, its cells may already be evaluated */
+static void tb_layout(PopUp *pop, Layout *vscroll, Tbdata *data, Label *status)
+{
+    uint32_t col;
+    uint32_t vscroll_ridx = popup_count(pop);
+    Layout *table = layout_create(1, 2);
+    Layout *ops = layout_create(1, 4);
+    Layout *add_col = layout_create(3, 1);
+    Layout *rem_col = layout_create(2, 1);
+    Layout *query_col = layout_create(3, 1);
+    Layout *status_row = layout_create(2, 1);
 
-                edit_phstyle(json_ppth, ekFITALIC);
-                edit_phtext(json_ppth, "json pointer path or expression");
-                layout_edit(add_col, json_ppth, 1, 0);
-                layout_hexpand(add_col, 1);
+    Edit *disp_name = edit_create();
+    Edit *json_ppth = edit_create();
+    Button *col_add = button_push();
 
-                button_text(col_add, "col add");
-                layout_button(add_col, col_add, 2, 0);
+    PopUp *col_name = popup_create();
+    Button *col_rem = button_push();
 
-                layout_layout(ops, add_col, 0, 0);
+    Edit *query_ppth = edit_create();
+    Button *query_run = button_push();
+    Edit *query_result = edit_create();
 
-                popup_add_elem(col_name, "column", NULL);
-                layout_popup(rem_col, col_name, 0, 0);
-                layout_hexpand(rem_col, 0);
+    Edit *line = edit_create();
+    Button *open = button_push();
 
-                button_text(col_rem, "col rem");
-                layout_button(rem_col, col_rem, 1, 0);
+    Font *font = font_system(font_regular_size(), 0);
+    TableView *tbview = tableview_create();
 
-                layout_layout(ops, rem_col, 0, 1);
+    edit_phstyle(disp_name, ekFITALIC);
+    edit_phtext(disp_name, "display name");
+    layout_edit(add_col, disp_name, 0, 0);
 
-                edit_phstyle(query_ppth, ekFITALIC);
-                edit_phtext(query_ppth, "json pointer path from root (ex: /items/0/kind) or expression");
-                layout_edit(query_col, query_ppth, 0, 0);
+    edit_phstyle(json_ppth, ekFITALIC);
+    edit_phtext(json_ppth, "json pointer path or expression");
+    layout_edit(add_col, json_ppth, 1, 0);
+    layout_hexpand(add_col, 1);
 
-                button_text(query_run, "query");
-                layout_button(query_col, query_run, 1, 0);
+    button_text(col_add, "col add");
+    layout_button(add_col, col_add, 2, 0);
 
-                edit_editable(query_result, FALSE);
-                layout_edit(query_col, query_result, 2, 0);
+    layout_layout(ops, add_col, 0, 0);
 
-                layout_hexpand2(query_col, 0, 2, .5f);
-                layout_layout(ops, query_col, 0, 2);
+    popup_add_elem(col_name, "column", NULL);
+    layout_popup(rem_col, col_name, 0, 0);
+    layout_hexpand(rem_col, 0);
 
-                edit_editable(line, FALSE);
-                edit_vpadding(line, 0);
-                layout_edit(status_row, line, 0, 0);
+    button_text(col_rem, "col rem");
+    layout_button(rem_col, col_rem, 1, 0);
 
-                button_text(open, "open");
-                layout_button(status_row, open, 1, 0);
+    layout_layout(ops, rem_col, 0, 1);
 
-                layout_hexpand(status_row, 0);
-                layout_layout(ops, status_row, 0, 3);
-                layout_vsize(ops, 3, 25);
+    edit_phstyle(query_ppth, ekFITALIC);
+    edit_phtext(query_ppth, "json pointer path from root (ex: /items/0/kind) or expression");
+    layout_edit(query_col, query_ppth, 0, 0);
 
-                layout_layout(table, ops, 0, 0);
+    button_text(query_run, "query");
+    layout_button(query_col, query_run, 1, 0);
 
-                layout_tableview(table, tbview, 0, 1);
-                layout_vexpand(table, 1);
+    edit_editable(query_result, FALSE);
+    layout_edit(query_col, query_result, 2, 0);
 
-                layout_insert_row(vscroll, vscroll_ridx);
-                layout_layout(vscroll, table, 0, vscroll_ridx);
+    layout_hexpand2(query_col, 0, 2, .5f);
+    layout_layout(ops, query_col, 0, 2);
 
-                data = tb_create_destroy(&destr, alc);
-                popup_add_elem(pop, "table", NULL);
-                data->mdoc = doc;
-                data->items = items;
-                data->nrows = yyjson_mut_arr_size(items);
-                data->freeze = 0;
-                data->status = status;
-                data->font_width = font_width(font);
-                font_destroy(&font);
-                arrst_foreach_const(col, json->cols, Column)
-                    if (data->ncols == MAX_COLS)
-                    {
-                        bstd_sprintf(data->tempstr, TEMP_STR_LEN, "+ max columns (%d) exceeded", MAX_COLS);
-                        label_text(data->status, data->tempstr);
-                        log_printf("columns more than %d are dropped", MAX_COLS);
-                        break;
-                    }
+    edit_editable(line, FALSE);
+    edit_vpadding(line, 0);
+    layout_edit(status_row, line, 0, 0);
 
-                    hlen = max_u32(bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", tc(col->display)), 1);
-                    tableview_header_title(tbview,
-                                           tableview_new_column_text(tbview),
-                                           data->tempstr);
-                    arrpt_append(data->expr, str_copy(col->expr), String);
-                    arrpt_append(data->display, str_copy(col->display), String);
+    button_text(open, "open");
+    layout_button(status_row, open, 1, 0);
 
-                    bstd_sprintf(data->tempstr, TEMP_STR_LEN, "[%d] %s", data->ncols, tc(col->display));
-                    popup_add_elem(col_name, data->tempstr, NULL);
+    layout_hexpand(status_row, 0);
+    layout_layout(ops, status_row, 0, 3);
+    layout_vsize(ops, 3, 25);
 
-                    arrst_append(data->widths, min_u32(hlen, TEMP_STR_LEN), uint32_t);
-                    arrst_append(data->widths, 0, uint32_t);
-                    tableview_column_limits(tbview, data->ncols,
-                                            data->font_width * *arrst_get(data->widths, data->ncols * 2, uint32_t),
-                                            data->font_width * (TEMP_STR_LEN + 1));
+    layout_layout(table, ops, 0, 0);
 
-                    data->freeze = col->freeze ? data->ncols : data->freeze;
+    layout_tableview(table, tbview, 0, 1);
+    layout_vexpand(table, 1);
 
-                    data->ncols++;
-                arrst_end()
+    layout_insert_row(vscroll, vscroll_ridx);
+    layout_layout(vscroll, table, 0, vscroll_ridx);
 
-                tableview_OnData(tbview, listener(data, tb_OnData, Tbdata));
-                tableview_OnHeaderClick(tbview, listener(data, tb_OnHeader, Tbdata));
-                tableview_header_resizable(tbview, FALSE);
-                tableview_column_freeze(tbview, data->freeze);
-                tableview_header_clickable(tbview, TRUE);
+    popup_add_elem(pop, "table", NULL);
+    data->status = status;
+    data->font_width = font_width(font);
+    font_destroy(&font);
+    if (data->dropped)
+    {
+        bstd_sprintf(data->tempstr, TEMP_STR_LEN, "+ max columns (%d) exceeded", MAX_COLS);
+        label_text(data->status, data->tempstr);
+    }
 
-                button_OnClick(col_add, listener(data, onCol_add, Tbdata));
-                button_OnClick(col_rem, listener(data, onCol_rem, Tbdata));
-                button_OnClick(query_run, listener(data, onQuery_run, Tbdata));
-                button_OnClick(open, listener(data, onRow_open, Tbdata));
+    for (col = 0; col < data->ncols; ++col)
+    {
+        const char_t *display = tc(arrpt_get_const(data->display, col, String));
+        bstd_sprintf(data->tempstr, TEMP_STR_LEN, "%s", display);
+        tableview_header_title(tbview,
+                               tableview_new_column_text(tbview),
+                               data->tempstr);
 
-                data->ops = ops;
-                data->tbview = tbview;
-                data->invalid = TRUE;
-                data->line = line;
-                data->uthread = ut;
+        bstd_sprintf(data->tempstr, TEMP_STR_LEN, "[%d] %s", col, display);
+        popup_add_elem(col_name, data->tempstr, NULL);
 
-                tableview_update(tbview);
-            }
-            json_destroy(&json, Columns);
-            stm_close(&stm);
-        }
+        tableview_column_limits(tbview, col,
+                                data->font_width * *arrst_get(data->widths, col * 2, uint32_t),
+                                data->font_width * (TEMP_STR_LEN + 1));
     }
+
+    tableview_OnData(tbview, listener(data, tb_OnData, Tbdata));
+    tableview_OnHeaderClick(tbview, listener(data, tb_OnHeader, Tbdata));
+    tableview_header_resizable(tbview, FALSE);
+    tableview_column_freeze(tbview, data->freeze);
+    tableview_header_clickable(tbview, TRUE);
+
+    button_OnClick(col_add, listener(data, onCol_add, Tbdata));
+    button_OnClick(col_rem, listener(data, onCol_rem, Tbdata));
+    button_OnClick(query_run, listener(data, onQuery_run, Tbdata));
+    button_OnClick(open, listener(data, onRow_open, Tbdata));
+
+    data->ops = ops;
+    data->tbview = tbview;
+    data->line = line;
+
+    tableview_update(tbview);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Destroyer *add_list_to_layout(UThread *ut, PopUp *pop, Layout *vscroll, yyjson_mut_doc *doc, Label *status, yyjson_alc *alc)
+{
+    Destroyer *destr = tb_profile(ut, doc, alc);
+    if (destr)
+        tb_layout(pop, vscroll, cast(destr->data, Tbdata), status);
     return destr;
 }
 
@@ -957,6 +1207,11 @@ static void ft_destroy(Ftdata **data)
         bproc_close(&(*data)->proc);
         cassert_msg(FALSE, "did not expect a process to be running");
     }
+    bmutex_close(&(*data)->mutex);
+#if defined(__LINUX__)
+    if ((*data)->memfd != -1)
+        close((*data)->memfd);
+#endif
     heap_delete(data, Ftdata);
 }
 
@@ -973,6 +1228,8 @@ static void ft_destroy_clr(const Destroyer *context)
 static Ftdata *ft_create_destroy(Destroyer **destr)
 {
     Ftdata *data = heap_new0(Ftdata);
+    data->mutex = bmutex_create();
+    data->memfd = -1;
     *destr = heap_new(Destroyer);
     FUNC_CHECK_DESTROY(ft_destroy, Ftdata);
     FUNC_CHECK_CLOSURE(ft_destroy_clr, Destroyer);
@@ -983,57 +1240,225 @@ static Ftdata *ft_create_destroy(Destroyer **destr)
 }
 
 /*---------------------------------------------------------------------------*/
-static uint32_t bg_proc_main(Ftdata *data)
+static bool_t i_stopped(Ftdata *data)
 {
-    bproc_wait_exit(&data->proc);
-    return 0;
+    bool_t stop;
+    bmutex_lock(data->mutex);
+    stop = data->stop;
+    bmutex_unlock(data->mutex);
+    return stop;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static void i_run_update(Ftdata *data)
+/* writes as much as the pipe takes, a slow reader only blocks the task */
+static void i_write(Ftdata *data)
 {
-    perror_t out, err;
-    bool_t read0 = TRUE;
-    if (data->run_state != ktRUN_INPROGRESS)
-    {
-        return;
-    }
-    else if (data->stop)
+    const byte_t *json = cast_const(data->json, byte_t);
+    size_t remain = data->json_len;
+    while (remain && !i_stopped(data))
     {
-        bproc_cancel(data->proc);
-        bproc_close(&data->proc);
-        data->run_state = ktRUN_CANCEL;
-        return;
+        uint32_t wsize = 0;
+        uint32_t size = remain < READ_BUFFER ? (uint32_t)remain : READ_BUFFER;
+        if (!bproc_write(data->proc, json, size, &wsize, NULL))
+            /* the command exited or was cancelled without reading it all */
+            break;
+        json += wsize;
+        remain -= wsize;
     }
+    bproc_write_close(data->proc);
+}
 
-    if (bproc_read(data->proc, data->read_buf, READ_BUFFER - 1, &data->rsize, &out))
-    {
-        data->read_buf[data->rsize] = '\0';
-        data->tot_len += data->rsize;
-        textview_color(data->tview, kCOLOR_DEFAULT);
-        textview_writef(data->tview, cast(data->read_buf, char_t));
-        read0 = FALSE;
-    }
+/*---------------------------------------------------------------------------*/
 
-    if (bproc_eread(data->proc, data->read_buf, READ_BUFFER - 1, &data->rsize, &err))
-    {
+static void i_stop(Ftdata *data)
+{
+    bmutex_lock(data->mutex);
+    data->stop = TRUE;
+    bmutex_unlock(data->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* NULL until the task started the command */
+static Proc *i_proc(Ftdata *data)
+{
+    Proc *proc;
+    bmutex_lock(data->mutex);
+    proc = data->proc;
+    bmutex_unlock(data->mutex);
+    return proc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* a stop before the command started leaves nothing to cancel, the task won't start it */
+static void i_cancel(Ftdata *data)
+{
+    bmutex_lock(data->mutex);
+    if (data->proc)
+        bproc_cancel(data->proc);
+    bmutex_unlock(data->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_run_read(Ftdata *data, perror_t *out, perror_t *err)
+{
+    bool_t read = FALSE;
+    if (bproc_read(data->proc, data->read_buf, READ_BUFFER - 1, &data->rsize, out))
+    {
+        data->read_buf[data->rsize] = '\0';
+        data->tot_len += data->rsize;
+        textview_color(data->tview, kCOLOR_DEFAULT);
+        textview_writef(data->tview, cast(data->read_buf, char_t));
+        read = TRUE;
+    }
+
+    if (bproc_eread(data->proc, data->read_buf, READ_BUFFER - 1, &data->rsize, err))
+    {
         data->read_buf[data->rsize] = '\0';
         data->tot_len += data->rsize;
         textview_color(data->tview, kCOLOR_RED);
         textview_writef(data->tview, cast(data->read_buf, char_t));
-        read0 = FALSE;
+        read = TRUE;
     }
 
-    if (read0 && out != ekPAGAIN && err != ekPAGAIN)
+    return read;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_run_update(Ftdata *data)
+{
+    perror_t out, err;
+    if (data->run_state != ktRUN_INPROGRESS)
+    {
+        return;
+    }
+    else if (i_stopped(data))
+    {
+        /* closed once the task is done, in i_run_end */
+        i_cancel(data);
+        data->run_state = ktRUN_CANCEL;
+        return;
+    }
+    else if (i_proc(data) == NULL)
+    {
+        /* the task is still writing the doc */
+        return;
+    }
+
+    if (i_run_read(data, &out, &err) == FALSE && out != ekPAGAIN && err != ekPAGAIN)
     {
-        bproc_close(&data->proc);
         data->run_state = ktRUN_COMPLETE;
     }
     else if (data->tot_len > READ_BUFFER)
     {
-        data->stop = TRUE;
+        i_stop(data);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_json_free(Ftdata *data)
+{
+    if (data->json)
+    {
+        if (data->alc)
+            data->alc->free(data->alc->ctx, data->json);
+        else
+            free(data->json);
+        data->json = NULL;
+        data->json_len = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(__LINUX__)
+
+/*
+ the compact doc is written once to a sealed memfd that the command opens as
+ its stdin, the doc doesn't change while the filter view exists so every
+ later run reuses it. runs on the task, FALSE if the memfd couldn't be made.
+*/
+static bool_t i_memfd_fill(Ftdata *data)
+{
+    if (data->memfd == -1)
+    {
+        yyjson_write_err werr;
+        size_t done = 0;
+        int fd = -1;
+        data->json = yyjson_mut_write_opts(data->mdoc, YYJSON_WRITE_NOFLAG, data->alc, &data->json_len, &werr);
+        if (data->json)
+            fd = memfd_create("kutes-filter", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+        while (fd != -1 && done < data->json_len)
+        {
+            ssize_t n = write(fd, data->json + done, data->json_len - done);
+            if (n > 0)
+            {
+                done += (size_t)n;
+            }
+            else
+            {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        if (fd != -1 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        i_json_free(data);
+        data->memfd = fd;
+    }
+    return data->memfd != -1;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* the doc is written and the command started here, the gui only reads the output */
+static uint32_t bg_proc_main(Ftdata *data)
+{
+    String *memcmd = NULL;
+    Proc *proc = NULL;
+#if defined(__LINUX__)
+    /* /proc opens the memfd again with its own offset, nothing has to be inherited */
+    if (data->use_memfd && i_memfd_fill(data))
+        memcmd = str_printf("exec 0</proc/%d/fd/%d; %s", (int)getpid(), data->memfd, tc(data->cmd));
+#endif
+    if (memcmd == NULL)
+    {
+        /* TODO: track if the buffer is changed or not */
+        yyjson_write_err werr;
+        data->json = yyjson_mut_write_opts(data->mdoc, YYJSON_WRITE_NOFLAG, data->alc, &data->json_len, &werr);
+        cassert_msg(werr.code == 0, "this is a parsed buf and shouldn't fail as size should be within limits");
     }
+
+    /* under the mutex so a stop either sees the Proc or keeps it from starting */
+    bmutex_lock(data->mutex);
+    if (!data->stop)
+        proc = bproc_exec(memcmd ? tc(memcmd) : tc(data->cmd), NULL);
+    data->proc = proc;
+    bmutex_unlock(data->mutex);
+    str_destopt(&memcmd);
+    if (proc == NULL)
+        return UINT32_MAX;
+
+    /* a cancel kills the process group so a blocked write fails too */
+    if (data->json)
+        i_write(data);
+    else
+        bproc_write_close(proc);
+    /* not bproc_wait_exit, its close pipe never hangs up while the Proc is open */
+    return bproc_wait(proc);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1041,6 +1466,26 @@ static void i_run_update(Ftdata *data)
 static void i_run_end(Ftdata *data, const uint32_t rval)
 {
     /* reset state */
+    if (data->proc)
+    {
+        /* the task can end before the update has seen the end of the output */
+        if (data->run_state == ktRUN_INPROGRESS)
+        {
+            perror_t out, err;
+            while (data->tot_len <= READ_BUFFER && i_run_read(data, &out, &err) == TRUE)
+            {
+            }
+            data->run_state = ktRUN_COMPLETE;
+        }
+        bproc_close(&data->proc);
+    }
+    else if (data->stop)
+    {
+        /* stopped before the command started */
+        data->run_state = ktRUN_CANCEL;
+    }
+    i_json_free(data);
+    str_destopt(&data->cmd);
     edit_editable(data->cmdin, TRUE);
     button_text(data->run, bt_run);
     data->stop = FALSE;
@@ -1074,7 +1519,7 @@ static void i_OnRun(Ftdata *data, Event *e)
     unref(e);
     if (data->run_state != ktRUN_ENDED)
     {
-        data->stop = TRUE;
+        i_stop(data);
         label_text(data->status, st_stopping);
         return;
     }
@@ -1166,31 +1611,13 @@ static void i_OnRun(Ftdata *data, Event *e)
     }
     else
     {
-        /* external command */
+        /* external command, serializing a large doc takes a while so the task does it */
         lock_view(data->locker, TRUE);
-        /* TODO: track if the buffer is changed or not */
-        json = yyjson_mut_write_opts(data->mdoc, YYJSON_WRITE_NOFLAG, data->alc, &len, &werr);
-        cassert_msg(werr.code == 0, "this is a parsed buf and shouldn't fail as size should be within limits");
-
-        data->proc = bproc_exec(cmdin, NULL);
-        {
-            uint32_t times = len / (READ_BUFFER - 1);
-            uint32_t remain = len % (READ_BUFFER - 1);
-            bool_t stop_write = FALSE;
-            while (times--)
-            {
-                if (bproc_write(data->proc, cast(json, byte_t), READ_BUFFER - 1, NULL, NULL) == FALSE)
-                {
-                    stop_write = TRUE;
-                    break;
-                }
-                json = json + (sizeof(char_t) * (READ_BUFFER - 1));
-            }
-            if (!stop_write && remain)
-                bproc_write(data->proc, cast(json, byte_t), remain, NULL, NULL);
-        }
+        data->cmd = str_c(cmdin);
+#if defined(__LINUX__)
+        data->use_memfd = button_get_state(data->shared) == ekGUI_ON;
+#endif
         data->run_state = ktRUN_INPROGRESS;
-        bproc_write_close(data->proc);
         edit_editable(data->cmdin, FALSE);
         button_text(data->run, bt_stop);
         osapp_task(data, 0., bg_proc_main, i_run_update, i_run_end, Ftdata);
@@ -1207,7 +1634,12 @@ static Destroyer *add_filter_to_layout(UThread *ut, PopUp *pop, Layout *vscroll,
 
     Layout *filter = layout_create(1, 2);
     Layout *cmd = layout_create(2, 1);
+#if defined(__LINUX__)
+    Layout *ops = layout_create(1, 3);
+    Button *shared = button_check();
+#else
     Layout *ops = layout_create(1, 2);
+#endif
 
     Edit *cmdin = edit_multiline();
 
@@ -1226,6 +1658,13 @@ static Destroyer *add_filter_to_layout(UThread *ut, PopUp *pop, Layout *vscroll,
     button_text(jptr, "jsonpointer");
     layout_button(ops, jptr, 0, 1);
 
+#if defined(__LINUX__)
+    /* off by default, the first run with it writes the whole doc before the command starts */
+    button_text(shared, "memfd");
+    button_tooltip(shared, "stdin is a sealed copy of the doc, made once and reused by every run");
+    layout_button(ops, shared, 0, 2);
+#endif
+
     layout_hexpand(cmd, 0);
     layout_layout(cmd, ops, 1, 0);
     layout_layout(filter, cmd, 0, 0);
@@ -1248,6 +1687,9 @@ static Destroyer *add_filter_to_layout(UThread *ut, PopUp *pop, Layout *vscroll,
     data->cmdin = cmdin;
     data->jptr = jptr;
     data->run = run;
+#if defined(__LINUX__)
+    data->shared = shared;
+#endif
     data->tview = tview;
     data->run_state = ktRUN_ENDED;
     data->locker = locker;
@@ -1264,36 +1706,481 @@ static Destroyer *add_filter_to_layout(UThread *ut, PopUp *pop, Layout *vscroll,
 
 /*---------------------------------------------------------------------------*/
 
-void populate_views(App *app)
+static void i_add_filter(App *app, yyjson_mut_doc *mdoc)
 {
-    yyjson_doc *doc = yyjson_read_opts(cast(app->parse_buf, char_t), app->out_len, YYJSON_READ_INSITU, app->alc, NULL);
-    if (doc)
+    /* the capture isn't needed once parsed, filter uses it as the pool for writing the doc */
+    Destroyer *destr = add_filter_to_layout(app->uthread, app->vselect, app->vscroll, app->locker, mdoc, spool_data(app->spool), spool_size(app->spool), app->status);
+    cassert_no_null(destr);
+    arrpt_append(app->views, destr, Destroyer);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_add_views(App *app, yyjson_mut_doc *mdoc, const char_t *kind)
+{
+    Destroyer *destr;
+    /* TODO: move the params to a shared struct after some point, let's say after 7 params? */
+    if (!blib_strcmp(kind, "List"))
     {
-        yyjson_val *kind = yyjson_doc_ptr_get(doc, "/kind");
-        Destroyer *destr;
-        if (kind)
+        destr = add_list_to_layout(app->uthread, app->vselect, app->vscroll, mdoc, app->status, app->alc);
+        cassert_no_null(destr);
+        arrpt_append(app->views, destr, Destroyer);
+    }
+    else
+    {
+        destr = add_kind_to_layout(app->vselect, app->vscroll, mdoc);
+        cassert_no_null(destr);
+        arrpt_append(app->views, destr, Destroyer);
+    }
+    i_add_filter(app, mdoc);
+    app->doc = mdoc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* lists of the api are kind PodList etc with items without kind, kubectl output is what views expect */
+static void i_kubectl_list(yyjson_mut_doc *mdoc)
+{
+    yyjson_mut_val *root = yyjson_mut_doc_get_root(mdoc);
+    yyjson_mut_val *kind = yyjson_mut_obj_get(root, "kind");
+    yyjson_mut_val *items = yyjson_mut_obj_get(root, "items");
+    const char_t *str = yyjson_mut_get_str(kind);
+    uint32_t len = (uint32_t)yyjson_mut_get_len(kind);
+    if (str && len > 4 && str_equ_c(str + len - 4, "List") && yyjson_mut_is_arr(items))
+    {
+        yyjson_mut_val *api = yyjson_mut_obj_get(root, "apiVersion");
+        yyjson_mut_val *item;
+        yyjson_mut_arr_iter iter;
+        yyjson_mut_arr_iter_init(items, &iter);
+        while ((item = yyjson_mut_arr_iter_next(&iter)) != NULL)
         {
-            yyjson_mut_doc *mdoc = yyjson_doc_mut_copy(doc, app->alc);
-            /* TODO: move the params to a shared struct after some point, let's say after 7 params? */
-            if (!blib_strcmp(yyjson_get_str(kind), "List"))
+            if (yyjson_mut_is_obj(item) && !yyjson_mut_obj_get(item, "kind"))
             {
-                destr = add_list_to_layout(app->uthread, app->vselect, app->vscroll, mdoc, app->status, app->alc);
-                cassert_no_null(destr);
-                arrpt_append(app->views, destr, Destroyer);
+                yyjson_mut_obj_add_strncpy(mdoc, item, "kind", str, len - 4);
+                if (api)
+                    yyjson_mut_obj_add_val(mdoc, item, "apiVersion", yyjson_mut_val_mut_copy(mdoc, api));
             }
-            else
-            {
-                destr = add_kind_to_layout(app->vselect, app->vscroll, mdoc);
-                cassert_no_null(destr);
-                arrpt_append(app->views, destr, Destroyer);
-            }
-            destr = add_filter_to_layout(app->uthread, app->vselect, app->vscroll, app->locker, mdoc, app->parse_buf, app->parse_size, app->status);
-            cassert_no_null(destr);
+        }
+        yyjson_mut_set_str(kind, "List");
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* doc of the captured output shaped like kubectl output or NULL */
+static yyjson_mut_doc *i_capture_doc(App *app)
+{
+    /* most of the doc is already built while the command was running */
+    yyjson_mut_doc *mdoc = scanner_finish(app->scanner, spool_data(app->spool), spool_len(app->spool));
+    if (!mdoc)
+    {
+        yyjson_doc *doc = yyjson_read_opts(cast(spool_data(app->spool), char_t), spool_len(app->spool), YYJSON_READ_INSITU, app->alc, NULL);
+        if (doc)
+        {
+            if (yyjson_doc_ptr_get(doc, "/kind"))
+                mdoc = yyjson_doc_mut_copy(doc, app->alc);
+            yyjson_doc_free(doc);
+        }
+    }
+
+    if (mdoc)
+        i_kubectl_list(mdoc);
+    return mdoc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the parsed capture, built on a task and turned into views on the gui thread */
+struct _pview_t
+{
+    yyjson_mut_doc *mdoc;
+    /* list table without its widgets, its cells are evaluated in steps */
+    Destroyer *table;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ runs on a task once the command completes, nothing else touches the scanner,
+ spool, allocator and boron thread of the app until the run ends. NULL if the
+ capture isn't shaped like kubectl output
+*/
+Pview *pview_create(App *app)
+{
+    yyjson_mut_doc *mdoc = i_capture_doc(app);
+    yyjson_mut_val *kind;
+    Pview *pv;
+    if (!mdoc)
+        return NULL;
+
+    kind = yyjson_mut_doc_ptr_get(mdoc, "/kind");
+    if (!yyjson_mut_is_str(kind))
+    {
+        yyjson_mut_doc_free(mdoc);
+        return NULL;
+    }
+
+    pv = heap_new0(Pview);
+    pv->mdoc = mdoc;
+    if (!blib_strcmp(yyjson_mut_get_str(kind), "List"))
+    {
+        pv->table = tb_profile(app->uthread, mdoc, app->alc);
+        if (pv->table)
+            tb_uncache(cast(pv->table->data, Tbdata));
+    }
+    return pv;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* evaluates the next rows of the table, TRUE while some are left */
+bool_t pview_step(Pview *pv, uint32_t *done, uint32_t *total)
+{
+    Tbdata *data;
+    bool_t more;
+    if (!pv->table)
+    {
+        *done = 0;
+        *total = 0;
+        return FALSE;
+    }
+
+    data = cast(pv->table->data, Tbdata);
+    more = tb_cache_rows(data, PVIEW_STEP);
+    *done = arrpt_size(data->rows, yyjson_mut_val);
+    *total = data->nrows;
+    if (!more)
+        data->invalid = FALSE;
+    return more;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pview_destroy(Pview **pv)
+{
+    if ((*pv)->table)
+    {
+        (*pv)->table->func_closure((*pv)->table);
+        heap_delete(&(*pv)->table, Destroyer);
+    }
+    if ((*pv)->mdoc)
+        yyjson_mut_doc_free((*pv)->mdoc);
+    heap_delete(pv, Pview);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* only the widgets are left to build, the views take the doc and the table */
+void populate_views(App *app, Pview **pv)
+{
+    yyjson_mut_doc *mdoc = (*pv)->mdoc;
+    if ((*pv)->table)
+    {
+        tb_layout(app->vselect, app->vscroll, cast((*pv)->table->data, Tbdata), app->status);
+        arrpt_append(app->views, (*pv)->table, Destroyer);
+        i_add_filter(app, mdoc);
+        app->doc = mdoc;
+    }
+    else
+    {
+        i_add_views(app, mdoc, yyjson_mut_get_str(yyjson_mut_doc_ptr_get(mdoc, "/kind")));
+    }
+    heap_delete(pv, Pview);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* new content for an item of the array, its place in the list (next) is kept */
+static ___INLINE void i_overwrite(yyjson_mut_val *dest, const yyjson_mut_val *src)
+{
+    yyjson_mut_val *next = dest->next;
+    *dest = *src;
+    dest->next = next;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE yyjson_mut_val *i_uid(yyjson_mut_val *item)
+{
+    return yyjson_mut_ptr_get(item, "/metadata/uid");
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void tb_uid(Tbdata *data, yyjson_mut_val *uid, const uint32_t row)
+{
+    raxInsert(data->uids, cast(yyjson_mut_get_str(uid), unsigned char), yyjson_mut_get_len(uid), cast((uintptr_t)row, void), NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the cell of the last row takes the place of the one at row */
+static void tb_col_move(TbCol *col, const uint32_t row, const uint32_t last)
+{
+    switch (col->type)
+    {
+    case ktINT:
+    case ktTIM:
+    case ktJVAL:
+        *arrst_get(col->ints, row, int64_t) = *arrst_get(col->ints, last, int64_t);
+        arrst_pop(col->ints, NULL, int64_t);
+        break;
+    case ktNUM:
+        *arrst_get(col->nums, row, real64_t) = *arrst_get(col->nums, last, real64_t);
+        arrst_pop(col->nums, NULL, real64_t);
+        break;
+    case ktBOOL:
+        *arrst_get(col->bools, row, bool_t) = *arrst_get(col->bools, last, bool_t);
+        arrst_pop(col->bools, NULL, bool_t);
+        break;
+    case ktSTR:
+        *arrst_get(col->strs, row, uint32_t) = *arrst_get(col->strs, last, uint32_t);
+        arrst_pop(col->strs, NULL, uint32_t);
+        break;
+    case ktUNK:
+        break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* only the cells of the row are evaluated again */
+static void tb_patch(Tbdata *data, const uint32_t row)
+{
+    tb_row(data, row);
+    if (row >= data->strow && row <= data->edrow)
+        data->redraw = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void tb_append(Tbdata *data, yyjson_mut_val *item)
+{
+    yyjson_mut_arr_append(data->items, item);
+    if (data->uids)
+        tb_uid(data, i_uid(item), data->nrows);
+
+    /* otherwise the next tb_cache builds the row with the rest */
+    if (!data->invalid)
+    {
+        arrpt_append(data->rows, item, yyjson_mut_val);
+        tb_row(data, data->nrows);
+    }
+    data->nrows++;
+    data->redraw = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the last row takes the place of the removed one */
+static void tb_remove(Tbdata *data, const uint32_t row)
+{
+    yyjson_mut_val **rows = arrpt_all(data->rows, yyjson_mut_val);
+    yyjson_mut_val *uid = i_uid(rows[row]);
+    uint32_t last = data->nrows - 1, col;
+    raxRemove(data->uids, cast(yyjson_mut_get_str(uid), unsigned char), yyjson_mut_get_len(uid), NULL);
+    for (col = 0; col < data->ncols; col++)
+        tb_col_move(data->cols + col, row, last);
+    if (row != last)
+    {
+        i_overwrite(rows[row], rows[last]);
+        tb_uid(data, i_uid(rows[row]), row);
+    }
+
+    /* unlinked by hand, yyjson would walk the whole list to find the item before the last */
+    if (last > 0)
+    {
+        rows[last - 1]->next = rows[last]->next;
+        data->items->uni.ptr = rows[last - 1];
+        unsafe_yyjson_set_len(data->items, last);
+    }
+    else
+    {
+        yyjson_mut_arr_clear(data->items);
+    }
+
+    arrpt_pop(data->rows, NULL, yyjson_mut_val);
+    data->nrows--;
+    data->redraw = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* copies the live items to a new doc, what MODIFIED events replaced is dropped */
+static void tb_compact(Tbdata *data)
+{
+    yyjson_mut_doc *mdoc = yyjson_mut_doc_mut_copy(data->mdoc, data->alc);
+    yyjson_mut_doc_free(data->mdoc);
+    data->mdoc = mdoc;
+    data->items = yyjson_mut_doc_ptr_get(mdoc, "/items");
+    data->stale = 0;
+    /* same order, the uid map stays valid */
+    data->invalid = TRUE;
+    data->redraw = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void tb_watch(Tbdata *data, const char_t *type, yyjson_val *object)
+{
+    yyjson_val *uid = yyjson_ptr_get(object, "/metadata/uid");
+    void *value = NULL;
+    int found;
+    if (!yyjson_is_str(uid))
+        return;
+
+    /* patches need the rows and cells of the current items */
+    tb_cache(data);
+    found = raxFind(data->uids, cast(yyjson_get_str(uid), unsigned char), yyjson_get_len(uid), &value);
+    if (str_equ_c(type, "DELETED"))
+    {
+        if (found)
+            tb_remove(data, (uint32_t)(uintptr_t)value);
+    }
+    else if (found)
+    {
+        uint32_t row = (uint32_t)(uintptr_t)value;
+        i_overwrite(arrpt_get(data->rows, row, yyjson_mut_val), yyjson_val_mut_copy(data->mdoc, object));
+        tb_patch(data, row);
+        data->stale++;
+    }
+    else
+    {
+        tb_append(data, yyjson_val_mut_copy(data->mdoc, object));
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ watch events patch the table by metadata.uid instead of listing again, the
+ table is created by the first object that is added.
+*/
+void populate_watch(App *app, yyjson_doc *event)
+{
+    yyjson_val *root = yyjson_doc_get_root(event);
+    const char_t *type = yyjson_get_str(yyjson_obj_get(root, "type"));
+    yyjson_val *object = yyjson_obj_get(root, "object");
+    Tbdata *data;
+    if (!type || !yyjson_is_obj(object) || str_equ_c(type, "BOOKMARK"))
+        return;
+
+    if (str_equ_c(type, "ERROR"))
+    {
+        const char_t *message = yyjson_get_str(yyjson_obj_get(object, "message"));
+        if (message)
+            label_text(app->status, message);
+        return;
+    }
+
+    if (!app->table)
+    {
+        yyjson_mut_doc *mdoc;
+        yyjson_mut_val *items;
+        Destroyer *destr;
+        if (str_equ_c(type, "DELETED") || !yyjson_is_str(yyjson_ptr_get(object, "/metadata/uid")))
+            return;
+
+        mdoc = yyjson_mut_doc_new(app->alc);
+        items = yyjson_mut_arr(mdoc);
+        yyjson_mut_doc_set_root(mdoc, yyjson_mut_obj(mdoc));
+        yyjson_mut_obj_add_str(mdoc, yyjson_mut_doc_get_root(mdoc), "kind", "List");
+        yyjson_mut_obj_add_val(mdoc, yyjson_mut_doc_get_root(mdoc), "items", items);
+        yyjson_mut_arr_append(items, yyjson_val_mut_copy(mdoc, object));
+        destr = add_list_to_layout(app->uthread, app->vselect, app->vscroll, mdoc, app->status, app->alc);
+        if (!destr)
+        {
+            /* no columns for this kind, the events are only shown as text */
+            yyjson_mut_doc_free(mdoc);
+            watch_ignore(app->watch);
+            return;
+        }
+
+        data = cast(destr->data, Tbdata);
+        data->uids = raxNew();
+        tb_uid(data, i_uid(yyjson_mut_arr_get_first(items)), 0);
+        arrpt_append(app->views, destr, Destroyer);
+        app->doc = mdoc;
+        app->table = destr;
+        return;
+    }
+
+    data = cast(app->table->data, Tbdata);
+    tb_watch(data, type, object);
+    if (data->stale > max_u32(data->nrows, WATCH_STALE))
+    {
+        tb_compact(data);
+        app->doc = data->mdoc;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ pages of a list fetched with limit, the first one creates the table and the
+ rest are appended to it. the continue token of the page is returned, the
+ filter view is added with the last page as it uses the capture as its pool.
+*/
+String *populate_page(App *app)
+{
+    yyjson_mut_doc *mdoc = i_capture_doc(app);
+    const char_t *token;
+    String *cont = NULL;
+    if (!mdoc)
+        return NULL;
+
+    token = yyjson_mut_get_str(yyjson_mut_doc_ptr_get(mdoc, "/metadata/continue"));
+    if (token && token[0])
+        cont = str_c(token);
+
+    if (!app->table)
+    {
+        yyjson_mut_val *kind = yyjson_mut_doc_ptr_get(mdoc, "/kind");
+        Destroyer *destr = NULL;
+        if (cont && yyjson_mut_equals_str(kind, "List"))
+            destr = add_list_to_layout(app->uthread, app->vselect, app->vscroll, mdoc, app->status, app->alc);
+
+        if (destr)
+        {
             arrpt_append(app->views, destr, Destroyer);
             app->doc = mdoc;
+            app->table = destr;
+        }
+        else
+        {
+            /* single page or nothing to append to */
+            str_destopt(&cont);
+            if (yyjson_mut_is_str(kind))
+                i_add_views(app, mdoc, yyjson_mut_get_str(kind));
+            else
+                yyjson_mut_doc_free(mdoc);
         }
-        yyjson_doc_free(doc);
     }
+    else
+    {
+        Tbdata *data = cast(app->table->data, Tbdata);
+        yyjson_mut_val *item;
+        yyjson_mut_arr_iter iter;
+        yyjson_mut_arr_iter_init(yyjson_mut_doc_ptr_get(mdoc, "/items"), &iter);
+        while ((item = yyjson_mut_arr_iter_next(&iter)) != NULL)
+            tb_append(data, yyjson_mut_val_mut_copy(data->mdoc, item));
+        yyjson_mut_doc_free(mdoc);
+
+        if (!cont)
+            i_add_filter(app, data->mdoc);
+    }
+    return cont;
 }
 
 /*---------------------------------------------------------------------------*/
+
+/* once per frame, the table is only redrawn for visible or added/removed rows */
+void refresh_table(App *app)
+{
+    Tbdata *data = app->table ? cast(app->table->data, Tbdata) : NULL;
+    if (data && data->redraw)
+    {
+        tableview_update(data->tbview);
+        data->redraw = FALSE;
+    }
+}
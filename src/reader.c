@@ -0,0 +1,189 @@
+/*
+ drains stdout/stderr of a process from the task thread straight into the
+ chunks of a ring, gui thread consumes whatever is already read. when the
+ ring is full the reader stops reading and the child blocks on its pipes.
+*/
+#include "kt.h"
+
+/* upper bound on how late a stop request is noticed */
+#define POLL_TIMEOUT 100
+/* wait before checking again for a released chunk when the ring is full */
+#define FULL_WAIT 2
+
+struct _reader_t
+{
+    Ring *ring;
+    Mutex *mutex;
+    bool_t stop;
+    bool_t running;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_stopped(Reader *reader)
+{
+    bool_t stop;
+    bmutex_lock(reader->mutex);
+    stop = reader->stop;
+    bmutex_unlock(reader->mutex);
+    return stop;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ fills one chunk from either pipe until it is full or the pipe is empty, pipe
+ reads are often much smaller than a chunk. FALSE if nothing was read.
+*/
+static bool_t i_read(Reader *reader, Kproc *proc, const bool_t err, bool_t *open)
+{
+    Chunk *chunk = ring_produce(reader->ring);
+    /* a byte is left for the consumer to null terminate the chunk */
+    uint32_t size = ring_chunk_size(reader->ring) - 1;
+    uint32_t len = 0;
+    cassert_no_null(chunk);
+    while (len < size)
+    {
+        uint32_t rsize = 0;
+        perror_t perr;
+        bool_t ok;
+        if (err)
+            ok = kproc_eread(proc, chunk->data + len, size - len, &rsize, &perr);
+        else
+            ok = kproc_read(proc, chunk->data + len, size - len, &rsize, &perr);
+
+        if (!ok)
+        {
+            if (perr != ekPAGAIN)
+                *open = FALSE;
+            break;
+        }
+        len += rsize;
+    }
+
+    if (len == 0)
+        return FALSE;
+
+    chunk->len = len;
+    chunk->err = err;
+    ring_publish(reader->ring);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Reader *reader_create(void)
+{
+    Reader *reader = heap_new0(Reader);
+    reader->ring = ring_create(RING_CHUNKS, READ_BUFFER);
+    reader->mutex = bmutex_create();
+    return reader;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void reader_destroy(Reader **reader)
+{
+    ring_destroy(&(*reader)->ring);
+    bmutex_close(&(*reader)->mutex);
+    heap_delete(reader, Reader);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* gui thread, before the task is scheduled */
+void reader_start(Reader *reader)
+{
+    ring_clear(reader->ring);
+    bmutex_lock(reader->mutex);
+    reader->stop = FALSE;
+    reader->running = TRUE;
+    bmutex_unlock(reader->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* runs in the task thread, returns FALSE if the process was cancelled */
+bool_t reader_run(Reader *reader, Kproc *proc)
+{
+    bool_t out_open = TRUE, err_open = TRUE;
+    while (out_open || err_open)
+    {
+        bool_t got = TRUE;
+        if (i_stopped(reader))
+        {
+            kproc_cancel(proc);
+            break;
+        }
+
+        /* backpressure, child blocks on a full pipe until the gui catches up */
+        if (!ring_produce(reader->ring))
+        {
+            bthread_sleep(FULL_WAIT);
+            continue;
+        }
+
+        if (!kproc_poll(proc, out_open, err_open, POLL_TIMEOUT))
+            continue;
+
+        /* drain both pipes, alternating so one doesn't starve the other */
+        while (got && (out_open || err_open) && ring_produce(reader->ring))
+        {
+            got = FALSE;
+            if (out_open)
+                got = i_read(reader, proc, FALSE, &out_open);
+
+            if (err_open && ring_produce(reader->ring))
+                got = i_read(reader, proc, TRUE, &err_open) || got;
+        }
+    }
+
+    bmutex_lock(reader->mutex);
+    reader->running = FALSE;
+    bmutex_unlock(reader->mutex);
+    return out_open || err_open ? FALSE : TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ gui thread, oldest chunk read so far or NULL, the chunk belongs to the
+ caller until reader_release and has room for a null terminator at len.
+*/
+Chunk *reader_chunk(Reader *reader)
+{
+    return ring_consume(reader->ring);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void reader_release(Reader *reader)
+{
+    ring_release(reader->ring);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void reader_stop(Reader *reader)
+{
+    bmutex_lock(reader->mutex);
+    reader->stop = TRUE;
+    bmutex_unlock(reader->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* stops and waits for the task thread to leave reader_run */
+void reader_cancel(Reader *reader)
+{
+    bool_t running = TRUE;
+    reader_stop(reader);
+    while (running)
+    {
+        bmutex_lock(reader->mutex);
+        running = reader->running;
+        bmutex_unlock(reader->mutex);
+        if (running)
+            bthread_sleep(10);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ bounded single producer single consumer ring of chunks, producer fills the
+ chunk buffer in place and publishes it, consumer releases it after use.
+ head is only written by the producer and tail only by the consumer.
+*/
+#include "kt.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define i_load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define i_store_release(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+#error "atomics are only wired for gcc/clang"
+#endif
+
+/* keeps head and tail on different cache lines */
+#define CACHE_LINE 64
+
+struct _ring_t
+{
+    uint32_t head;
+    byte_t pad0[CACHE_LINE - sizeof(uint32_t)];
+    uint32_t tail;
+    byte_t pad1[CACHE_LINE - sizeof(uint32_t)];
+    uint32_t mask;
+    uint32_t chunk_size;
+    Chunk *chunks;
+    byte_t *data;
+};
+
+/*---------------------------------------------------------------------------*/
+
+Ring *ring_create(const uint32_t nchunks, const uint32_t chunk_size)
+{
+    Ring *ring = heap_new0(Ring);
+    uint32_t i;
+    cassert(nchunks && !(nchunks & (nchunks - 1)));
+    ring->mask = nchunks - 1;
+    ring->chunk_size = chunk_size;
+    ring->chunks = heap_new_n0(nchunks, Chunk);
+    ring->data = heap_new_n(nchunks * chunk_size, byte_t);
+    for (i = 0; i < nchunks; ++i)
+        ring->chunks[i].data = ring->data + (i * chunk_size);
+    return ring;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void ring_destroy(Ring **ring)
+{
+    uint32_t nchunks = (*ring)->mask + 1;
+    heap_delete_n(&(*ring)->data, nchunks * (*ring)->chunk_size, byte_t);
+    heap_delete_n(&(*ring)->chunks, nchunks, Chunk);
+    heap_delete(ring, Ring);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* only when neither side is active */
+void ring_clear(Ring *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t ring_chunk_size(const Ring *ring)
+{
+    return ring->chunk_size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* producer, chunk to be filled or NULL if consumer is behind */
+Chunk *ring_produce(Ring *ring)
+{
+    uint32_t head = ring->head;
+    if (head - i_load_acquire(&ring->tail) > ring->mask)
+        return NULL;
+    return ring->chunks + (head & ring->mask);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void ring_publish(Ring *ring)
+{
+    i_store_release(&ring->head, ring->head + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* consumer, oldest published chunk or NULL if empty */
+Chunk *ring_consume(Ring *ring)
+{
+    uint32_t tail = ring->tail;
+    if (tail == i_load_acquire(&ring->head))
+        return NULL;
+    return ring->chunks + (tail & ring->mask);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void ring_release(Ring *ring)
+{
+    i_store_release(&ring->tail, ring->tail + 1);
+}
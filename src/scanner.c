@@ -0,0 +1,364 @@
+/*
+ structural scan of stdout while it is still arriving. kubectl lists are an
+ object with an "items" array, every element of it is parsed as soon as its
+ closing brace is seen and copied into a mutable doc. any other object or
+ array member of the root is parsed the same way once it closes, so only one
+ member at a time exists as an immutable tree next to its mutable copy. a
+ single big member (the data of a ConfigMap, the spec of a CRD) is still
+ doubled while it's copied, the whole resource isn't. the scalars left are
+ parsed once the run completes. anything not shaped like an object gives up
+ and the caller falls back to parsing the whole capture.
+*/
+#include "kt.h"
+
+typedef enum _scan_t
+{
+    ekSCAN_ROOT,
+    ekSCAN_OBJECT,
+    ekSCAN_ITEMS_VALUE,
+    ekSCAN_ITEMS,
+    ekSCAN_DONE,
+    ekSCAN_FAIL
+} scan_t;
+
+typedef struct _member_t Member;
+struct _member_t
+{
+    /* value and key in the capture */
+    uint32_t start;
+    uint32_t end;
+    uint32_t key;
+    uint32_t klen;
+    yyjson_mut_val *val;
+};
+
+DeclSt(Member);
+
+struct _scanner_t
+{
+    yyjson_alc *alc;
+    yyjson_mut_doc *mdoc;
+    yyjson_mut_val *items;
+    scan_t state;
+    uint32_t pos;
+    uint32_t depth;
+    uint32_t key_start;
+    uint32_t key_end;
+    uint32_t items_start;
+    uint32_t elem_start;
+    uint32_t value_start;
+    bool_t in_str;
+    bool_t esc;
+    bool_t key_esc;
+    /* root members already parsed, in the order of the capture */
+    ArrSt(Member) *members;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static void i_fail(Scanner *scanner)
+{
+    if (scanner->mdoc)
+    {
+        yyjson_mut_doc_free(scanner->mdoc);
+        scanner->mdoc = NULL;
+        scanner->items = NULL;
+    }
+    arrst_clear(scanner->members, NULL, Member);
+    scanner->state = ekSCAN_FAIL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* mutable copy of the value at [start, end) or NULL if it isn't valid, both exist until the copy is done */
+static yyjson_mut_val *i_parse(Scanner *scanner, const byte_t *data, const uint32_t start, const uint32_t end)
+{
+    yyjson_doc *doc = yyjson_read_opts(cast(data + start, char_t), end - start, YYJSON_READ_NOFLAG, scanner->alc, NULL);
+    yyjson_mut_val *val = NULL;
+    if (doc)
+    {
+        if (!scanner->mdoc)
+            scanner->mdoc = yyjson_mut_doc_new(scanner->alc);
+        val = yyjson_val_mut_copy(scanner->mdoc, yyjson_doc_get_root(doc));
+        yyjson_doc_free(doc);
+    }
+    return val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_element(Scanner *scanner, const byte_t *data, const uint32_t end)
+{
+    yyjson_mut_val *val = i_parse(scanner, data, scanner->elem_start, end);
+    if (val)
+    {
+        if (!scanner->items)
+            scanner->items = yyjson_mut_arr(scanner->mdoc);
+        yyjson_mut_arr_append(scanner->items, val);
+    }
+    else
+    {
+        i_fail(scanner);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_member(Scanner *scanner, const uint32_t start, const uint32_t end, yyjson_mut_val *val)
+{
+    Member *member = arrst_new(scanner->members, Member);
+    member->start = start;
+    member->end = end;
+    member->key = scanner->key_start;
+    member->klen = scanner->key_end - scanner->key_start;
+    member->val = val;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_value(Scanner *scanner, const byte_t *data, const uint32_t end)
+{
+    /* an escaped key wouldn't match the parsed one, the value stays for the end */
+    if (scanner->key_esc == FALSE)
+    {
+        yyjson_mut_val *val = i_parse(scanner, data, scanner->value_start, end);
+        if (val)
+            i_member(scanner, scanner->value_start, end, val);
+        else
+            i_fail(scanner);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_is_items(const Scanner *scanner, const byte_t *data)
+{
+    return scanner->key_end - scanner->key_start == 5 && bmem_cmp(data + scanner->key_start, cast_const("items", byte_t), 5) == 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Scanner *scanner_create(yyjson_alc *alc)
+{
+    Scanner *scanner = heap_new0(Scanner);
+    scanner->alc = alc;
+    scanner->members = arrst_create(Member);
+    return scanner;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void scanner_destroy(Scanner **scanner)
+{
+    scanner_reset(*scanner);
+    arrst_destroy(&(*scanner)->members, NULL, Member);
+    heap_delete(scanner, Scanner);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void scanner_reset(Scanner *scanner)
+{
+    yyjson_alc *alc = scanner->alc;
+    ArrSt(Member) *members = scanner->members;
+    if (scanner->mdoc)
+        yyjson_mut_doc_free(scanner->mdoc);
+    arrst_clear(members, NULL, Member);
+    bmem_zero(scanner, Scanner);
+    scanner->alc = alc;
+    scanner->members = members;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* data is the whole capture so far, only the bytes after the previous call are scanned */
+void scanner_feed(Scanner *scanner, const byte_t *data, const uint32_t len)
+{
+    uint32_t i;
+    for (i = scanner->pos; i < len && scanner->state != ekSCAN_FAIL; ++i)
+    {
+        byte_t c = data[i];
+        if (scanner->in_str)
+        {
+            if (scanner->esc)
+            {
+                scanner->esc = FALSE;
+            }
+            else if (c == '\\')
+            {
+                scanner->esc = TRUE;
+                if (scanner->depth == 1)
+                    scanner->key_esc = TRUE;
+            }
+            else if (c == '"')
+            {
+                scanner->in_str = FALSE;
+                if (scanner->depth == 1)
+                    scanner->key_end = i;
+            }
+            continue;
+        }
+
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+            break;
+
+        case '"':
+            if (scanner->depth == 1 && scanner->state == ekSCAN_OBJECT)
+            {
+                scanner->key_start = i + 1;
+                scanner->key_esc = FALSE;
+                scanner->in_str = TRUE;
+            }
+            else if (scanner->depth > 2 || (scanner->depth == 2 && scanner->state != ekSCAN_ITEMS))
+                scanner->in_str = TRUE;
+            else
+                /* string as items or as one of its elements */
+                i_fail(scanner);
+            break;
+
+        case '{':
+        case '[':
+            if (scanner->state == ekSCAN_ROOT)
+            {
+                if (c == '{')
+                    scanner->state = ekSCAN_OBJECT;
+                else
+                    i_fail(scanner);
+            }
+            else if (scanner->state == ekSCAN_ITEMS_VALUE)
+            {
+                if (c == '[')
+                {
+                    scanner->state = ekSCAN_ITEMS;
+                    scanner->items_start = i;
+                }
+                else
+                    i_fail(scanner);
+            }
+            else if (scanner->state == ekSCAN_ITEMS && scanner->depth == 2)
+            {
+                scanner->elem_start = i;
+            }
+            else if (scanner->state == ekSCAN_OBJECT && scanner->depth == 1)
+            {
+                scanner->value_start = i;
+            }
+            else if (scanner->state == ekSCAN_DONE)
+            {
+                i_fail(scanner);
+            }
+            scanner->depth++;
+            break;
+
+        case '}':
+        case ']':
+            if (scanner->depth == 0)
+            {
+                i_fail(scanner);
+                break;
+            }
+            scanner->depth--;
+            if (scanner->state == ekSCAN_ITEMS)
+            {
+                if (scanner->depth == 2)
+                {
+                    i_element(scanner, data, i + 1);
+                }
+                else if (scanner->depth == 1)
+                {
+                    /* an empty array stays for the end */
+                    if (scanner->items)
+                        i_member(scanner, scanner->items_start, i + 1, scanner->items);
+                    scanner->state = ekSCAN_OBJECT;
+                }
+            }
+            else if (scanner->state == ekSCAN_OBJECT && scanner->depth == 1)
+            {
+                i_value(scanner, data, i + 1);
+            }
+            else if (scanner->depth == 0)
+            {
+                scanner->state = ekSCAN_DONE;
+            }
+            break;
+
+        case ':':
+            if (scanner->depth == 1 && scanner->state == ekSCAN_OBJECT && i_is_items(scanner, data))
+                scanner->state = ekSCAN_ITEMS_VALUE;
+            break;
+
+        case ',':
+            if (scanner->state == ekSCAN_ITEMS_VALUE)
+                i_fail(scanner);
+            break;
+
+        default:
+            /* numbers, literals or trailing data, none of them is expected outside an element */
+            if (scanner->state != ekSCAN_OBJECT && scanner->depth <= 2)
+                i_fail(scanner);
+            break;
+        }
+    }
+    scanner->pos = len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ doc built from the parsed members and the rest of the root object or NULL
+ when the capture wasn't a complete object, the doc belongs to the caller.
+*/
+yyjson_mut_doc *scanner_finish(Scanner *scanner, const byte_t *data, const uint32_t len)
+{
+    yyjson_mut_doc *mdoc = NULL;
+    scanner_feed(scanner, data, len);
+    if (scanner->state == ekSCAN_DONE && scanner->mdoc)
+    {
+        /* root object with a 0 in place of every parsed value */
+        uint32_t n = arrst_size(scanner->members, Member);
+        uint32_t size = len, pos = 0, at = 0, i;
+        byte_t *skel = NULL;
+        yyjson_doc *doc;
+        arrst_foreach_const(member, scanner->members, Member)
+            size -= member->end - member->start - 1;
+        arrst_end()
+
+        skel = heap_new_n(size, byte_t);
+        arrst_foreach_const(member, scanner->members, Member)
+            bmem_copy(skel + at, data + pos, member->start - pos);
+            at += member->start - pos;
+            skel[at++] = '0';
+            pos = member->end;
+        arrst_end()
+        bmem_copy(skel + at, data + pos, len - pos);
+        doc = yyjson_read_opts(cast(skel, char_t), size, YYJSON_READ_NOFLAG, scanner->alc, NULL);
+        heap_delete_n(&skel, size, byte_t);
+        if (doc)
+        {
+            yyjson_mut_val *root = yyjson_val_mut_copy(scanner->mdoc, yyjson_doc_get_root(doc));
+            yyjson_doc_free(doc);
+            for (i = 0; i < n; ++i)
+            {
+                const Member *member = arrst_get_const(scanner->members, i, Member);
+                yyjson_mut_val *key = yyjson_mut_strn(scanner->mdoc, cast_const(data + member->key, char_t), member->klen);
+                if (!yyjson_mut_obj_replace(root, key, member->val))
+                    break;
+            }
+
+            if (i == n)
+            {
+                yyjson_mut_doc_set_root(scanner->mdoc, root);
+                mdoc = scanner->mdoc;
+                scanner->mdoc = NULL;
+                scanner->items = NULL;
+            }
+        }
+    }
+    scanner_reset(scanner);
+    return mdoc;
+}
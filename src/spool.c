@@ -0,0 +1,188 @@
+/*
+ capture buffer for stdout, a large virtual range is reserved up front and
+ only the pages that are written get backed by memory. appending never moves
+ the data so there are no copies while growing and the capture can be parsed
+ in place. linux backs it with a memfd, other unix with anonymous memory and
+ windows commits the reserved range in steps.
+*/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+#include "kt.h"
+
+#if defined(__WINDOWS__)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x64__) || defined(__ARM64__)
+#define SPOOL_RESERVE (2048u * 1024u * 1024u)
+#else
+#define SPOOL_RESERVE (256u * 1024u * 1024u)
+#endif
+
+/* windows only, committed memory grows in these steps */
+#define SPOOL_COMMIT (4 * 1024 * 1024)
+
+struct _spool_t
+{
+    byte_t *data;
+    uint32_t len;
+    uint32_t capacity;
+    uint32_t committed;
+    int fd;
+};
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(__WINDOWS__)
+
+static bool_t i_commit(Spool *spool, const uint32_t size)
+{
+    uint32_t committed = spool->committed;
+    while (committed < size)
+        committed += SPOOL_COMMIT;
+    committed = min_u32(committed, spool->capacity);
+    if (committed > spool->committed)
+    {
+        if (VirtualAlloc(spool->data + spool->committed, committed - spool->committed, MEM_COMMIT, PAGE_READWRITE) == NULL)
+            return FALSE;
+        spool->committed = committed;
+    }
+    return TRUE;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+Spool *spool_create(void)
+{
+    Spool *spool = heap_new0(Spool);
+    spool->capacity = SPOOL_RESERVE;
+    spool->fd = -1;
+#if defined(__WINDOWS__)
+    spool->data = cast(VirtualAlloc(NULL, spool->capacity, MEM_RESERVE, PAGE_NOACCESS), byte_t);
+    cassert_no_null(spool->data);
+    i_commit(spool, SPOOL_COMMIT);
+#else
+    {
+        void *map = MAP_FAILED;
+#if defined(__LINUX__)
+        /* sparse, pages are only allocated once touched */
+        spool->fd = memfd_create("kutes-spool", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (spool->fd != -1 && ftruncate(spool->fd, spool->capacity) == 0)
+            map = mmap(NULL, spool->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, spool->fd, 0);
+
+        if (map == MAP_FAILED && spool->fd != -1)
+        {
+            close(spool->fd);
+            spool->fd = -1;
+        }
+#endif
+        if (map == MAP_FAILED)
+        {
+            int flags = MAP_PRIVATE | MAP_ANON;
+#if defined(MAP_NORESERVE)
+            flags |= MAP_NORESERVE;
+#endif
+            map = mmap(NULL, spool->capacity, PROT_READ | PROT_WRITE, flags, -1, 0);
+        }
+        cassert(map != MAP_FAILED);
+        spool->data = cast(map, byte_t);
+        spool->committed = spool->capacity;
+    }
+#endif
+    return spool;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void spool_destroy(Spool **spool)
+{
+    cassert_no_null(spool);
+    cassert_no_null(*spool);
+#if defined(__WINDOWS__)
+    VirtualFree((*spool)->data, 0, MEM_RELEASE);
+#else
+    munmap((*spool)->data, (*spool)->capacity);
+    if ((*spool)->fd != -1)
+        close((*spool)->fd);
+#endif
+    heap_delete(spool, Spool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* drops the captured data and gives the pages back to the system */
+void spool_reset(Spool *spool)
+{
+#if defined(__WINDOWS__)
+    if (spool->committed > SPOOL_COMMIT)
+    {
+        VirtualFree(spool->data + SPOOL_COMMIT, spool->committed - SPOOL_COMMIT, MEM_DECOMMIT);
+        spool->committed = SPOOL_COMMIT;
+    }
+#else
+    if (spool->fd != -1)
+    {
+        /* truncating frees the pages, the mapping stays valid once the size is back */
+        int ret = ftruncate(spool->fd, 0);
+        if (ret == 0)
+            ret = ftruncate(spool->fd, spool->capacity);
+        cassert(ret == 0);
+        unref(ret);
+    }
+    else
+    {
+        madvise(spool->data, spool->capacity, MADV_DONTNEED);
+    }
+#endif
+    spool->len = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ FALSE once the reserved range is exhausted. the data is always followed by
+ YYJSON_PADDING_SIZE zero bytes so it can be parsed in place.
+*/
+bool_t spool_append(Spool *spool, const byte_t *data, const uint32_t size)
+{
+    if (size > spool->capacity - YYJSON_PADDING_SIZE - spool->len)
+        return FALSE;
+
+#if defined(__WINDOWS__)
+    if (!i_commit(spool, spool->len + size + YYJSON_PADDING_SIZE))
+        return FALSE;
+#endif
+
+    bmem_copy(spool->data + spool->len, data, size);
+    spool->len += size;
+    bmem_zero_n(spool->data + spool->len, YYJSON_PADDING_SIZE, byte_t);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *spool_data(Spool *spool)
+{
+    return spool->data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t spool_len(const Spool *spool)
+{
+    return spool->len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* bytes from spool_data that are accessible right now, at least the captured length */
+uint32_t spool_size(const Spool *spool)
+{
+    return spool->committed;
+}
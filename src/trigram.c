@@ -0,0 +1,245 @@
+/*
+ line level trigram index over the captured stdout. every trigram maps to the
+ ascending numbers of the lines that contain it, kept as varint deltas in one
+ buffer. it's built in two passes over the same lines, the first sizes every
+ list and the second writes them in place. keys take 7 bits of each byte so
+ ascii trigrams are exact, other bytes share keys and the caller verifies
+ every candidate line anyway. a smaller capture gets fewer keys, trigrams are
+ hashed into them and share keys the same way.
+*/
+#include "kt.h"
+
+/* every ascii trigram has its own key with this many bits */
+#define TRI_BITS 21
+#define TRI_MIN_BITS 16
+/* bytes of capture per key, offs and last take 8 bytes per key while building */
+#define TRI_KEY_BYTES 8
+/* a longer pattern is filtered on its first trigrams only */
+#define TRI_QUERY 32
+
+struct _trigram_t
+{
+    /* list k spans [offs[k], offs[k + 1]) of data once built */
+    uint32_t *offs;
+    /* last line added to each list while building, lines count from 1 */
+    uint32_t *last;
+    uint32_t bits;
+    uint32_t keys;
+    byte_t *data;
+    uint32_t size;
+    uint32_t line;
+    bool_t sized;
+    /* start offset of every line */
+    ArrSt(uint32_t) *starts;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE uint32_t i_key(const Trigram *tri, const byte_t *text)
+{
+    uint32_t key = ((uint32_t)(text[0] & 0x7F) << 14) | ((uint32_t)(text[1] & 0x7F) << 7) | (uint32_t)(text[2] & 0x7F);
+    if (tri->bits < TRI_BITS)
+        /* fibonacci hashing, the top bits are the best mixed */
+        key = (key * 2654435761u) >> (32 - tri->bits);
+    return key;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE uint32_t i_varint_size(uint32_t value)
+{
+    uint32_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size += 1;
+    }
+    return size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE uint32_t i_varint_write(byte_t *data, uint32_t value)
+{
+    uint32_t size = 0;
+    while (value >= 0x80)
+    {
+        data[size++] = (byte_t)(value | 0x80);
+        value >>= 7;
+    }
+    data[size++] = (byte_t)value;
+    return size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ___INLINE uint32_t i_varint_read(const byte_t **data)
+{
+    uint32_t value = 0, shift = 0;
+    while (**data & 0x80)
+    {
+        value |= (uint32_t)(**data & 0x7F) << shift;
+        shift += 7;
+        *data += 1;
+    }
+    value |= (uint32_t)**data << shift;
+    *data += 1;
+    return value;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the keys follow size, the bytes that will be indexed */
+Trigram *trigram_create(const uint32_t size)
+{
+    Trigram *tri = heap_new0(Trigram);
+    tri->bits = TRI_MIN_BITS;
+    while (tri->bits < TRI_BITS && (1u << tri->bits) < size / TRI_KEY_BYTES)
+        tri->bits += 1;
+    tri->keys = 1u << tri->bits;
+    tri->offs = heap_new_n0(tri->keys + 1, uint32_t);
+    tri->last = heap_new_n0(tri->keys, uint32_t);
+    tri->starts = arrst_create(uint32_t);
+    return tri;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void trigram_destroy(Trigram **tri)
+{
+    if ((*tri)->last != NULL)
+        heap_delete_n(&(*tri)->last, (*tri)->keys, uint32_t);
+    if ((*tri)->data != NULL)
+        heap_delete_n(&(*tri)->data, (*tri)->size, byte_t);
+    heap_delete_n(&(*tri)->offs, (*tri)->keys + 1, uint32_t);
+    arrst_destroy(&(*tri)->starts, NULL, uint32_t);
+    heap_delete(tri, Trigram);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* lines come in order from offset 0, the same lines on both passes */
+void trigram_line(Trigram *tri, const byte_t *text, const uint32_t len, const uint32_t pos)
+{
+    uint32_t i;
+    tri->line += 1;
+    if (tri->sized == FALSE)
+        arrst_append(tri->starts, pos, uint32_t);
+
+    for (i = 0; i + 3 <= len; ++i)
+    {
+        uint32_t key = i_key(tri, text + i);
+        uint32_t delta = tri->line - tri->last[key];
+        if (delta == 0)
+            continue;
+
+        /* the first pass counts into offs[key + 1], the second writes from there */
+        if (tri->sized == FALSE)
+            tri->offs[key + 1] += i_varint_size(delta);
+        else
+            tri->offs[key + 1] += i_varint_write(tri->data + tri->offs[key + 1], delta);
+        tri->last[key] = tri->line;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* ends a pass, the index is usable after the second one */
+void trigram_seal(Trigram *tri)
+{
+    if (tri->sized == FALSE)
+    {
+        uint32_t k, total = 0;
+        for (k = 0; k < tri->keys; ++k)
+        {
+            uint32_t size = tri->offs[k + 1];
+            tri->offs[k + 1] = total;
+            total += size;
+        }
+        tri->size = max_u32(total, 1);
+        tri->data = heap_new_n(tri->size, byte_t);
+        bmem_zero_n(tri->last, tri->keys, uint32_t);
+        tri->line = 0;
+        tri->sized = TRUE;
+    }
+    else
+    {
+        /* every cursor stopped where the next list starts */
+        heap_delete_n(&tri->last, tri->keys, uint32_t);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* keeps the lines that are also in the list of key, returns how many */
+static uint32_t i_intersect(const Trigram *tri, const uint32_t key, uint32_t *lines, const uint32_t n)
+{
+    const byte_t *data = tri->data + tri->offs[key];
+    const byte_t *end = tri->data + tri->offs[key + 1];
+    uint32_t i, kept = 0, line = 0;
+    for (i = 0; i < n; ++i)
+    {
+        while (line < lines[i] && data < end)
+            line += i_varint_read(&data);
+        if (line == lines[i])
+            lines[kept++] = line;
+        else if (line < lines[i])
+            break;
+    }
+    return kept;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* start offsets of the lines that may contain pattern, which has 3 or more bytes */
+void trigram_lines(const Trigram *tri, const byte_t *pattern, const uint32_t plen, ArrSt(uint32_t) *starts)
+{
+    uint32_t keys[TRI_QUERY];
+    uint32_t i, j, nkeys = 0, shortest = 0, size, n = 0;
+    uint32_t *lines = NULL;
+    cassert(tri->last == NULL);
+    cassert(plen >= 3);
+    for (i = 0; i + 3 <= plen && nkeys < TRI_QUERY; ++i)
+    {
+        uint32_t key = i_key(tri, pattern + i);
+        for (j = 0; j < nkeys && keys[j] != key; ++j)
+        {
+        }
+        if (j == nkeys)
+            keys[nkeys++] = key;
+    }
+
+    /* decodes the shortest list and filters it with the others */
+    for (i = 1; i < nkeys; ++i)
+    {
+        if (tri->offs[keys[i] + 1] - tri->offs[keys[i]] < tri->offs[keys[shortest] + 1] - tri->offs[keys[shortest]])
+            shortest = i;
+    }
+
+    /* a list holds at most one line per byte */
+    size = tri->offs[keys[shortest] + 1] - tri->offs[keys[shortest]];
+    if (size == 0)
+        return;
+
+    lines = heap_new_n(size, uint32_t);
+    {
+        const byte_t *data = tri->data + tri->offs[keys[shortest]];
+        const byte_t *end = data + size;
+        uint32_t line = 0;
+        while (data < end)
+        {
+            line += i_varint_read(&data);
+            lines[n++] = line;
+        }
+    }
+
+    for (i = 0; i < nkeys && n > 0; ++i)
+    {
+        if (i != shortest)
+            n = i_intersect(tri, keys[i], lines, n);
+    }
+
+    for (i = 0; i < n; ++i)
+        arrst_append(starts, *arrst_get_const(tri->starts, lines[i] - 1, uint32_t), uint32_t);
+    heap_delete_n(&lines, size, uint32_t);
+}
@@ -0,0 +1,212 @@
+/*
+ makes output valid utf8 before it's displayed, toolkits reject or slowly
+ sanitize anything else. ascii runs are skipped 16 bytes at a time with sse2,
+ multibyte sequences are checked one by one. invalid bytes become '?' in
+ place so the chunk never grows, a sequence cut at the end of a chunk is held
+ back and completed with the first bytes of the next one.
+*/
+#include "kt.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_SSE2
+#include <emmintrin.h>
+#endif
+
+struct _utf8_t
+{
+    /* incomplete sequence at the end of the last chunk */
+    byte_t held[4];
+    uint32_t held_len;
+    /* that sequence completed, shown before the body */
+    byte_t head[4];
+    uint32_t head_len;
+    byte_t *body;
+    uint32_t body_len;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* bytes of a valid sequence at text, 0 if invalid, partial when text ends inside a valid prefix */
+static uint32_t i_sequence(const byte_t *text, const uint32_t size, bool_t *partial)
+{
+    byte_t c = text[0], lo = 0x80, hi = 0xBF;
+    uint32_t len = 0, i;
+    *partial = FALSE;
+    if (c >= 0xC2 && c <= 0xDF)
+    {
+        len = 2;
+    }
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+        len = 3;
+        /* no overlongs and no surrogates */
+        if (c == 0xE0)
+            lo = 0xA0;
+        else if (c == 0xED)
+            hi = 0x9F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+        len = 4;
+        /* no overlongs and nothing past U+10FFFF */
+        if (c == 0xF0)
+            lo = 0x90;
+        else if (c == 0xF4)
+            hi = 0x8F;
+    }
+    else
+    {
+        return 0;
+    }
+
+    for (i = 1; i < len; ++i)
+    {
+        if (i == size)
+        {
+            *partial = TRUE;
+            return 0;
+        }
+
+        if (i == 1 ? (text[i] < lo || text[i] > hi) : (text[i] & 0xC0) != 0x80)
+            return 0;
+    }
+
+    return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* replaces invalid bytes in place, returns how many bytes at the end are an incomplete sequence */
+static uint32_t i_repair(byte_t *text, const uint32_t size)
+{
+    uint32_t i = 0;
+    while (i < size)
+    {
+        uint32_t len;
+        bool_t partial;
+#if defined(UTF8_SSE2)
+        while (i + 16 <= size && _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(text + i))) == 0)
+            i += 16;
+#endif
+        while (i < size && text[i] < 0x80)
+            i += 1;
+
+        if (i == size)
+            break;
+
+        len = i_sequence(text + i, size - i, &partial);
+        if (len > 0)
+        {
+            i += len;
+        }
+        else if (partial == TRUE)
+        {
+            return size - i;
+        }
+        else
+        {
+            text[i] = '?';
+            i += 1;
+        }
+    }
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Utf8 *utf8_create(void)
+{
+    return heap_new0(Utf8);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void utf8_destroy(Utf8 **utf8)
+{
+    heap_delete(utf8, Utf8);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* drops a held sequence, the next chunk starts clean */
+void utf8_reset(Utf8 *utf8)
+{
+    utf8->held_len = 0;
+    utf8->head_len = 0;
+    utf8->body = NULL;
+    utf8->body_len = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ repairs data in place, utf8_next hands it out. an empty chunk ends the
+ output and lets a held sequence out as '?'
+*/
+void utf8_feed(Utf8 *utf8, byte_t *data, const uint32_t size)
+{
+    uint32_t start = 0, held = 0;
+    utf8->head_len = 0;
+    if (utf8->held_len > 0)
+    {
+        /* continuation bytes the held sequence still needs */
+        bool_t partial;
+        uint32_t len = utf8->held_len;
+        bmem_copy(utf8->head, utf8->held, len);
+        while (start < size && len < 4 && (data[start] & 0xC0) == 0x80)
+            utf8->head[len++] = data[start++];
+
+        if (i_sequence(utf8->head, len, &partial) == 0 && partial == TRUE && start == size && size > 0)
+        {
+            /* a tiny chunk, still not complete */
+            bmem_copy(utf8->held, utf8->head, len);
+            utf8->held_len = len;
+            len = 0;
+        }
+        else
+        {
+            utf8->held_len = 0;
+            held = i_repair(utf8->head, len);
+            /* cut by a byte that can't continue it */
+            while (held > 0)
+                utf8->head[len - held--] = '?';
+        }
+
+        utf8->head_len = len;
+    }
+
+    utf8->body = data + start;
+    utf8->body_len = size - start;
+    held = i_repair(utf8->body, utf8->body_len);
+    if (held > 0)
+    {
+        utf8->body_len -= held;
+        bmem_copy(utf8->held, utf8->body + utf8->body_len, held);
+        utf8->held_len = held;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the completed held sequence first, then the rest of the chunk */
+bool_t utf8_next(Utf8 *utf8, const byte_t **text, uint32_t *len)
+{
+    if (utf8->head_len > 0)
+    {
+        *text = utf8->head;
+        *len = utf8->head_len;
+        utf8->head_len = 0;
+        return TRUE;
+    }
+
+    if (utf8->body_len > 0)
+    {
+        *text = utf8->body;
+        *len = utf8->body_len;
+        utf8->body_len = 0;
+        return TRUE;
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,224 @@
+/*
+ framing of watch output, the api server sends one event per line and
+ kubectl --output-watch-events prints indented objects, both are a sequence
+ of top level objects like {"type": "ADDED", "object": {...}}. the output is
+ taken as a watch once the first key of the first object is "type", from
+ then on only the incomplete tail is kept and every complete event is parsed
+ on its own.
+*/
+#include "kt.h"
+
+#define WATCH_BUFFER (64 * 1024)
+
+typedef enum _wstate_t
+{
+    ekWATCH_PENDING,
+    ekWATCH_KEY,
+    ekWATCH_ACTIVE,
+    ekWATCH_NONE
+} wstate_t;
+
+struct _watch_t
+{
+    yyjson_alc *alc;
+    byte_t *buf;
+    uint32_t len;
+    uint32_t size;
+    uint32_t pos;
+    uint32_t start;
+    uint32_t depth;
+    wstate_t state;
+    bool_t in_str;
+    bool_t esc;
+    /* first key while it is still being detected */
+    char_t key[8];
+    uint32_t key_len;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* decides from the first bytes if the output is a watch, consumes them */
+static const byte_t *i_detect(Watch *watch, const byte_t *data, const byte_t *end)
+{
+    while (data < end && (watch->state == ekWATCH_PENDING || watch->state == ekWATCH_KEY))
+    {
+        byte_t c = *data;
+        if (watch->state == ekWATCH_PENDING)
+        {
+            if (c == '{')
+                watch->state = ekWATCH_KEY;
+            else if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                watch->state = ekWATCH_NONE;
+            data++;
+        }
+        else if (!watch->in_str)
+        {
+            if (c == '"')
+                watch->in_str = TRUE;
+            else if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                watch->state = ekWATCH_NONE;
+            data++;
+        }
+        else if (c == '"')
+        {
+            watch->in_str = FALSE;
+            watch->state = watch->key_len == 4 && bmem_cmp(cast(watch->key, byte_t), cast_const("type", byte_t), 4) == 0 ? ekWATCH_ACTIVE : ekWATCH_NONE;
+            data++;
+        }
+        else if (watch->key_len < 4)
+        {
+            watch->key[watch->key_len++] = (char_t)c;
+            data++;
+        }
+        else
+        {
+            watch->state = ekWATCH_NONE;
+        }
+    }
+    return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Watch *watch_create(yyjson_alc *alc)
+{
+    Watch *watch = heap_new0(Watch);
+    watch->alc = alc;
+    return watch;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void watch_destroy(Watch **watch)
+{
+    cassert_no_null(watch);
+    cassert_no_null(*watch);
+    if ((*watch)->buf)
+        heap_delete_n(&(*watch)->buf, (*watch)->size, byte_t);
+    heap_delete(watch, Watch);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void watch_reset(Watch *watch)
+{
+    yyjson_alc *alc = watch->alc;
+    if (watch->buf)
+        heap_delete_n(&watch->buf, watch->size, byte_t);
+    bmem_zero(watch, Watch);
+    watch->alc = alc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the rest of the output is plain text, like when a table can't be built for it */
+void watch_ignore(Watch *watch)
+{
+    watch_reset(watch);
+    watch->state = ekWATCH_NONE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* TRUE while the output is a watch, the caller doesn't need to capture it then */
+bool_t watch_feed(Watch *watch, const byte_t *data, const uint32_t len)
+{
+    const byte_t *end = data + len;
+    bool_t detected = FALSE;
+    if (watch->state == ekWATCH_NONE)
+        return FALSE;
+
+    if (watch->state != ekWATCH_ACTIVE)
+    {
+        data = i_detect(watch, data, end);
+        if (watch->state != ekWATCH_ACTIVE)
+            return FALSE;
+
+        /* the opening brace and the key were consumed by the detection */
+        watch->in_str = FALSE;
+        watch->depth = 1;
+        detected = TRUE;
+    }
+
+    if (watch->len + (uint32_t)(end - data) + (detected ? 7 : 0) > watch->size)
+    {
+        uint32_t size = max_u32(watch->size, WATCH_BUFFER);
+        byte_t *buf;
+        while (size < watch->len + (uint32_t)(end - data) + 7)
+            size *= 2;
+        buf = heap_new_n(size, byte_t);
+        if (watch->buf)
+        {
+            bmem_copy(buf, watch->buf, watch->len);
+            heap_delete_n(&watch->buf, watch->size, byte_t);
+        }
+        watch->buf = buf;
+        watch->size = size;
+    }
+
+    if (detected)
+    {
+        bmem_copy(watch->buf, cast_const("{\"type\"", byte_t), 7);
+        watch->len = 7;
+        watch->pos = 7;
+    }
+
+    bmem_copy(watch->buf + watch->len, data, (uint32_t)(end - data));
+    watch->len += (uint32_t)(end - data);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* next complete event or NULL, the doc belongs to the caller */
+yyjson_doc *watch_next(Watch *watch)
+{
+    uint32_t i;
+    if (watch->state != ekWATCH_ACTIVE)
+        return NULL;
+
+    for (i = watch->pos; i < watch->len; ++i)
+    {
+        byte_t c = watch->buf[i];
+        if (watch->in_str)
+        {
+            if (watch->esc)
+                watch->esc = FALSE;
+            else if (c == '\\')
+                watch->esc = TRUE;
+            else if (c == '"')
+                watch->in_str = FALSE;
+        }
+        else if (c == '"')
+        {
+            watch->in_str = TRUE;
+        }
+        else if (c == '{' || c == '[')
+        {
+            if (watch->depth++ == 0)
+                watch->start = i;
+        }
+        else if ((c == '}' || c == ']') && watch->depth > 0 && --watch->depth == 0)
+        {
+            yyjson_doc *doc = yyjson_read_opts(cast(watch->buf + watch->start, char_t), i + 1 - watch->start, YYJSON_READ_NOFLAG, watch->alc, NULL);
+            /* the tail is moved to the front once everything complete is consumed */
+            watch->pos = i + 1;
+            if (doc)
+                return doc;
+        }
+    }
+
+    if (watch->depth == 0)
+    {
+        watch->len = 0;
+        watch->start = 0;
+    }
+    else if (watch->start > 0)
+    {
+        bmem_move(watch->buf, watch->buf + watch->start, watch->len - watch->start);
+        watch->len -= watch->start;
+        watch->start = 0;
+    }
+    watch->pos = watch->len;
+    return NULL;
+}
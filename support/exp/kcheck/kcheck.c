@@ -0,0 +1,203 @@
+/*
+ scripted check of kapi.c against kstub, 'make kapi-check' in support starts
+ the stub and runs this with KUTES_APISERVER pointing at it. a list, a paged
+ list, a watch and a missing path are read the way reader.c reads a command
+ and the exit code is the number of checks that failed.
+   kcheck [pods]
+*/
+#include "kt.h"
+
+#include <inet/inet.h>
+#include <stdlib.h>
+
+#define CHECK_PODS 50
+#define CHECK_LIMIT 20
+#define CHECK_POLL 100
+/* ready polls in a row that gave nothing to read, more means kapi_poll spins */
+#define CHECK_STALLS 4
+
+typedef struct _get_t Get;
+struct _get_t
+{
+    Stream *out;
+    Stream *err;
+    uint32_t code;
+    uint32_t stalls;
+};
+
+/*---------------------------------------------------------------------------*/
+
+/* poll, read and eread until the response is finished, like reader_run */
+static Get i_get(const char_t *path)
+{
+    Get get;
+    byte_t buf[READ_BUFFER];
+    Kapi *api = kapi_open(path);
+    uint32_t stalls = 0;
+    get.out = stm_memory(READ_BUFFER);
+    get.err = stm_memory(READ_BUFFER);
+    get.code = UINT32_MAX;
+    get.stalls = 0;
+    for (;;)
+    {
+        bool_t ready = kapi_poll(api, CHECK_POLL), got = FALSE;
+        uint32_t rsize;
+        perror_t error;
+        while (kapi_read(api, buf, sizeof(buf), &rsize, &error))
+        {
+            stm_write(get.out, buf, rsize);
+            got = TRUE;
+        }
+
+        while (kapi_eread(api, buf, sizeof(buf), &rsize, &error))
+        {
+            stm_write(get.err, buf, rsize);
+            got = TRUE;
+        }
+
+        if (kapi_finish(api, &get.code))
+            break;
+
+        stalls = ready && !got ? stalls + 1 : 0;
+        get.stalls = max_u32(get.stalls, stalls);
+    }
+    kapi_close(&api);
+    return get;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_get_dest(Get *get)
+{
+    stm_close(&get->out);
+    stm_close(&get->err);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_check(const bool_t ok, const char_t *what, const Get *get)
+{
+    bstd_printf("%s %s (code %d, stalls %u)\n", ok ? "ok  " : "FAIL", what, (int32_t)get->code, get->stalls);
+    return ok ? 0 : 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* items of a list body and its continue token, UINT32_MAX when it isn't a list */
+static uint32_t i_items(const Get *get, String **token)
+{
+    uint32_t n = UINT32_MAX;
+    yyjson_doc *doc = yyjson_read(cast_const(stm_buffer(get->out), char_t), stm_buffer_size(get->out), 0);
+    yyjson_val *root = yyjson_doc_get_root(doc);
+    yyjson_val *items = yyjson_obj_get(root, "items");
+    const char_t *cont = yyjson_get_str(yyjson_obj_get(yyjson_obj_get(root, "metadata"), "continue"));
+    if (yyjson_is_arr(items))
+        n = (uint32_t)yyjson_arr_size(items);
+    if (token)
+        *token = cont && cont[0] ? str_c(cont) : NULL;
+    yyjson_doc_free(doc);
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_list(const uint32_t pods)
+{
+    Get get = i_get("/api/v1/pods");
+    String *token = NULL;
+    uint32_t n = i_items(&get, &token);
+    uint32_t failed = i_check(get.code == 0 && n == pods && token == NULL && get.stalls <= CHECK_STALLS, "list", &get);
+    str_destopt(&token);
+    i_get_dest(&get);
+    return failed;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_paged(const uint32_t pods)
+{
+    String *first = str_printf("/api/v1/pods?limit=%u", CHECK_LIMIT);
+    String *path = str_copy(first);
+    uint32_t total = 0, pages = 0, failed;
+    bool_t ok = kapi_paged(tc(first));
+    Get get;
+    for (;;)
+    {
+        String *token = NULL;
+        uint32_t n;
+        get = i_get(tc(path));
+        n = i_items(&get, &token);
+        ok = ok && get.code == 0 && n <= CHECK_LIMIT && get.stalls <= CHECK_STALLS;
+        total += n;
+        pages += 1;
+        str_destroy(&path);
+        if (!ok || token == NULL)
+        {
+            str_destopt(&token);
+            break;
+        }
+        path = kapi_page(tc(first), tc(token));
+        str_destroy(&token);
+        i_get_dest(&get);
+    }
+
+    failed = i_check(ok && total == pods && pages == (pods + CHECK_LIMIT - 1) / CHECK_LIMIT, "paged list", &get);
+    str_destroy(&first);
+    i_get_dest(&get);
+    return failed;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_watch(const uint32_t pods)
+{
+    Get get = i_get("/api/v1/pods?watch=1");
+    const char_t *line = cast_const(stm_buffer(get.out), char_t);
+    const char_t *end = line + stm_buffer_size(get.out);
+    uint32_t added = 0, bookmarks = 0, failed;
+    while (line < end)
+    {
+        const char_t *next = line;
+        while (next < end && *next != '\n')
+            next++;
+        if (next - line > 16 && str_equ_cn(line, "{\"type\":\"ADDED\"", 15))
+            added++;
+        else if (next - line > 19 && str_equ_cn(line, "{\"type\":\"BOOKMARK\"", 18))
+            bookmarks++;
+        line = next + 1;
+    }
+    failed = i_check(get.code == 0 && added == pods && bookmarks == 1 && get.stalls <= CHECK_STALLS, "watch", &get);
+    i_get_dest(&get);
+    return failed;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_missing(void)
+{
+    Get get = i_get("/api/v1/nothing");
+    const char_t *reason = "\"reason\":\"NotFound\"";
+    bool_t found = FALSE;
+    uint32_t i, size = stm_buffer_size(get.err), rlen = str_len_c(reason), failed;
+    const char_t *err = cast_const(stm_buffer(get.err), char_t);
+    for (i = 0; i + rlen <= size && !found; ++i)
+        found = str_equ_cn(err + i, reason, rlen);
+    failed = i_check(get.code == 1 && stm_buffer_size(get.out) == 0 && found, "missing path", &get);
+    i_get_dest(&get);
+    return failed;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    uint32_t pods = argc > 1 ? (uint32_t)atoi(argv[1]) : CHECK_PODS;
+    uint32_t failed = 0;
+    inet_start();
+    failed += i_list(pods);
+    failed += i_paged(pods);
+    failed += i_watch(pods);
+    failed += i_missing();
+    inet_finish();
+    return (int)failed;
+}
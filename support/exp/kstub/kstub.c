@@ -0,0 +1,224 @@
+/*
+ stand in for the api server to try kapi.c without a cluster, plain http on
+ localhost like kubectl proxy. any path ending in /pods is a PodList that
+ honors limit and continue (the token is the offset), watch=1 streams the
+ pods as ADDED events in chunked encoding and closes with a BOOKMARK, each
+ chunk size line arrives in two writes.
+ everything else is a 404 Status.
+   kstub [port] [pods]
+   KUTES_APISERVER=http://127.0.0.1:8001 kutes
+*/
+#include <osbs/osbs.h>
+#include <osbs/bsocket.h>
+#include <osbs/bthread.h>
+#include <sewer/bstd.h>
+#include <sewer/cassert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STUB_PORT 8001
+#define STUB_PODS 50
+#define STUB_REQUEST 4096
+#define STUB_BODY (1024 * 1024)
+#define STUB_EVENT_WAIT 20
+/* between the two writes of a chunk size line */
+#define STUB_SPLIT_WAIT 100
+
+/*---------------------------------------------------------------------------*/
+
+/* head are the fields written before metadata, the kind in watch events */
+static uint32_t i_pod(char_t *dest, const uint32_t size, const uint32_t n, const char_t *head)
+{
+    return bstd_sprintf(dest, size,
+                        "{%s\"metadata\":{\"name\":\"stub-%u\",\"namespace\":\"default\",\"uid\":\"00000000-0000-0000-0000-%012u\",\"resourceVersion\":\"%u\"},"
+                        "\"spec\":{\"nodeName\":\"stub-node\",\"containers\":[{\"name\":\"main\",\"image\":\"busybox\"}]},"
+                        "\"status\":{\"phase\":\"Running\",\"podIP\":\"10.0.%u.%u\"}}",
+                        head, n, n, 1000 + n, n / 250, n % 250 + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* value of a query parameter or NULL, the query starts after '?' */
+static const char_t *i_param(const char_t *query, const char_t *name, uint32_t *len)
+{
+    uint32_t nlen = (uint32_t)strlen(name);
+    const char_t *p = query;
+    while (p != NULL && *p != '\0')
+    {
+        const char_t *end = strchr(p, '&');
+        if (strncmp(p, name, nlen) == 0 && p[nlen] == '=')
+        {
+            *len = end ? (uint32_t)(end - p - nlen - 1) : (uint32_t)strlen(p + nlen + 1);
+            return p + nlen + 1;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_uparam(const char_t *query, const char_t *name, const uint32_t def)
+{
+    uint32_t len;
+    const char_t *value = i_param(query, name, &len);
+    if (value && len > 0)
+        return (uint32_t)strtoul(value, NULL, 10);
+    return def;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_send(Socket *socket, const char_t *data, const uint32_t size)
+{
+    bsocket_write(socket, cast_const(data, byte_t), size, NULL, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_response(Socket *socket, const char_t *status, const char_t *body, const uint32_t len)
+{
+    char_t head[256];
+    uint32_t n = bstd_sprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", status, len);
+    i_send(socket, head, n);
+    i_send(socket, body, len);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the size line is cut before its '\n' like a slow server would, clients must wait for the rest */
+static void i_chunk(Socket *socket, const char_t *data, const uint32_t len)
+{
+    char_t size[16];
+    uint32_t n = bstd_sprintf(size, sizeof(size), "%x\r\n", len);
+    i_send(socket, size, n - 1);
+    bthread_sleep(STUB_SPLIT_WAIT);
+    i_send(socket, size + n - 1, 1);
+    i_send(socket, data, len);
+    i_send(socket, "\r\n", 2);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_list(Socket *socket, const char_t *query, const uint32_t pods, char_t *body)
+{
+    uint32_t offset = i_uparam(query, "continue", 0);
+    uint32_t limit = i_uparam(query, "limit", 0);
+    uint32_t end = pods;
+    uint32_t len = 0, i;
+    if (limit > 0 && offset + limit < pods)
+        end = offset + limit;
+
+    len += bstd_sprintf(body + len, STUB_BODY - len, "{\"kind\":\"PodList\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"%u\"", 1000 + pods);
+    if (end < pods)
+        len += bstd_sprintf(body + len, STUB_BODY - len, ",\"continue\":\"%u\",\"remainingItemCount\":%u", end, pods - end);
+    len += bstd_sprintf(body + len, STUB_BODY - len, "},\"items\":[");
+    for (i = offset; i < end && len < STUB_BODY - 512; ++i)
+    {
+        if (i > offset)
+            body[len++] = ',';
+        len += i_pod(body + len, STUB_BODY - len, i, "");
+    }
+    len += bstd_sprintf(body + len, STUB_BODY - len, "]}");
+    i_response(socket, "200 OK", body, len);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_watch(Socket *socket, const uint32_t pods, char_t *body)
+{
+    const char_t *head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n";
+    uint32_t i, len;
+    i_send(socket, head, (uint32_t)strlen(head));
+    for (i = 0; i < pods; ++i)
+    {
+        len = bstd_sprintf(body, STUB_BODY, "{\"type\":\"ADDED\",\"object\":");
+        len += i_pod(body + len, STUB_BODY - len, i, "\"kind\":\"Pod\",\"apiVersion\":\"v1\",");
+        len += bstd_sprintf(body + len, STUB_BODY - len, "}\n");
+        i_chunk(socket, body, len);
+        bthread_sleep(STUB_EVENT_WAIT);
+    }
+    len = bstd_sprintf(body, STUB_BODY, "{\"type\":\"BOOKMARK\",\"object\":{\"kind\":\"Pod\",\"apiVersion\":\"v1\",\"metadata\":{\"resourceVersion\":\"%u\"}}}\n", 1000 + pods);
+    i_chunk(socket, body, len);
+    i_send(socket, "0\r\n\r\n", 5);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_serve(Socket *socket, const uint32_t pods, char_t *body)
+{
+    char_t req[STUB_REQUEST];
+    uint32_t len = 0, rsize;
+    char_t *path, *query, *end;
+    bsocket_read_timeout(socket, 2000);
+    while (len < STUB_REQUEST - 1 && bsocket_recv(socket, cast(req + len, byte_t), STUB_REQUEST - 1 - len, &rsize, NULL))
+    {
+        len += rsize;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n"))
+            break;
+    }
+    req[len] = '\0';
+
+    if (strncmp(req, "GET ", 4) != 0)
+    {
+        i_response(socket, "400 Bad Request", "{}", 2);
+        return;
+    }
+
+    path = req + 4;
+    end = strchr(path, ' ');
+    if (end)
+        *end = '\0';
+    query = strchr(path, '?');
+    if (query)
+        *query++ = '\0';
+
+    bstd_printf("GET %s%s%s\n", path, query ? "?" : "", query ? query : "");
+    len = (uint32_t)strlen(path);
+    if (len >= 5 && strcmp(path + len - 5, "/pods") == 0)
+    {
+        uint32_t wlen;
+        const char_t *watch = query ? i_param(query, "watch", &wlen) : NULL;
+        if (watch && ((wlen == 1 && watch[0] == '1') || (wlen == 4 && strncmp(watch, "true", 4) == 0)))
+            i_watch(socket, pods, body);
+        else
+            i_list(socket, query, pods, body);
+    }
+    else
+    {
+        const char_t *status = "{\"kind\":\"Status\",\"apiVersion\":\"v1\",\"status\":\"Failure\",\"message\":\"the server could not find the requested resource\",\"reason\":\"NotFound\",\"code\":404}";
+        i_response(socket, "404 Not Found", status, (uint32_t)strlen(status));
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : STUB_PORT;
+    uint32_t pods = argc > 2 ? (uint32_t)atoi(argv[2]) : STUB_PODS;
+    char_t *body = NULL;
+    Socket *server = NULL;
+    serror_t err;
+    osbs_start();
+    server = bsocket_server(port, 8, &err);
+    if (!server)
+    {
+        bstd_printf("kstub: cannot listen on %u\n", port);
+        osbs_finish();
+        return 1;
+    }
+
+    bstd_printf("kstub: http://127.0.0.1:%u with %u pods\n", port, pods);
+    body = cast(malloc(STUB_BODY), char_t);
+    for (;;)
+    {
+        Socket *client = bsocket_accept(server, 0, &err);
+        if (client)
+        {
+            i_serve(client, pods, body);
+            bsocket_close(&client);
+        }
+    }
+}
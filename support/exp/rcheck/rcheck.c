@@ -0,0 +1,226 @@
+/*
+ scripted check of the lazy dfa behind regex_find, 'make regex-check' in
+ support runs this. small random patterns over short random lines are
+ compared with a brute force leftmost-longest search made of regex_match
+ calls, then patterns that need more dfa states than a cache holds are run
+ over long lines. the exit code is the number of checks that failed.
+   rcheck [seed]
+*/
+#include <core/core.h>
+#include <core/arrst.h>
+#include <core/regex.h>
+#include <sewer/blib.h>
+#include <sewer/bstd.h>
+#include <sewer/cassert.h>
+#include <stdlib.h>
+
+#define CHECK_SEED 1
+#define CHECK_PATTERNS 300
+#define CHECK_TEXTS 20
+#define CHECK_TEXT 48
+#define CHECK_ATOMS 5
+/* 'a', 13 any and 'c' needs 2^14 states for the search, far over a cache */
+#define CHECK_WIDE "a.............c"
+#define CHECK_WIDE_GAP 14
+
+static uint32_t i_SEED = CHECK_SEED;
+
+/*---------------------------------------------------------------------------*/
+
+/* own generator so a seed gives the same run everywhere */
+static uint32_t i_rand(const uint32_t n)
+{
+    i_SEED ^= i_SEED << 13;
+    i_SEED ^= i_SEED >> 17;
+    i_SEED ^= i_SEED << 5;
+    return i_SEED % n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_pattern(char_t *pattern)
+{
+    static const char_t *ATOMS[] = {"a", "b", "c", ".", "[ab]", "[bc]", "(ab)", "(ca)", "a-b"};
+    uint32_t i, n = 1 + i_rand(CHECK_ATOMS);
+    pattern[0] = '\0';
+    for (i = 0; i < n; ++i)
+    {
+        blib_strcat(pattern, 64, ATOMS[i_rand(sizeof(ATOMS) / sizeof(ATOMS[0]))]);
+        if (i_rand(3) == 0)
+            blib_strcat(pattern, 64, "*");
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_text(char_t *text, const uint32_t max, const char_t *alpha)
+{
+    uint32_t i, n = i_rand(max + 1), na = blib_strlen(alpha);
+    for (i = 0; i < n; ++i)
+        text[i] = alpha[i_rand(na)];
+    text[n] = '\0';
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* leftmost-longest non empty match in a line, the same contract as regex_find */
+static uint32_t i_brute(const RegEx *regex, const char_t *text, const uint32_t size, const uint32_t from, uint32_t *len)
+{
+    char_t sub[CHECK_TEXT + 1];
+    uint32_t st;
+    for (st = from; st < size; ++st)
+    {
+        uint32_t eol = st, end;
+        while (eol < size && text[eol] != '\n')
+            eol += 1;
+        for (end = eol; end > st; --end)
+        {
+            blib_strncpy(sub, CHECK_TEXT + 1, text + st, end - st);
+            if (regex_match(regex, sub) == TRUE)
+            {
+                *len = end - st;
+                return st;
+            }
+        }
+    }
+    return UINT32_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* every match of regex_find_all against the brute force, same order */
+static bool_t i_same(const RegEx *regex, const char_t *text, const uint32_t size, ArrSt(uint32_t) *matches)
+{
+    uint32_t i, n, pos, len = 0;
+    arrst_clear(matches, NULL, uint32_t);
+    n = regex_find_all(regex, text, size, matches);
+    pos = i_brute(regex, text, size, 0, &len);
+    for (i = 0; i < n; ++i)
+    {
+        const uint32_t *m = arrst_get_const(matches, 2 * i, uint32_t);
+        if (pos != m[0] || len != m[1])
+            return FALSE;
+        pos = i_brute(regex, text, size, pos + len, &len);
+    }
+    return (bool_t)(pos == UINT32_MAX);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_check(const bool_t ok, const char_t *what, const char_t *pattern, const uint32_t size)
+{
+    bstd_printf("%s %s (%s, %u bytes)\n", ok ? "ok  " : "FAIL", what, pattern, size);
+    return ok ? 0 : 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_random(void)
+{
+    char_t pattern[64];
+    char_t text[CHECK_TEXT + 1];
+    ArrSt(uint32_t) *matches = arrst_create(uint32_t);
+    uint32_t i, j, failed = 0;
+    for (i = 0; i < CHECK_PATTERNS && failed == 0; ++i)
+    {
+        RegEx *regex;
+        i_pattern(pattern);
+        regex = regex_create(pattern);
+        if (regex == NULL)
+            continue;
+
+        for (j = 0; j < CHECK_TEXTS && failed == 0; ++j)
+        {
+            uint32_t size = i_text(text, CHECK_TEXT, "aabbc\n");
+            if (i_same(regex, text, size, matches) == FALSE)
+                failed = i_check(FALSE, "random", pattern, size);
+        }
+        regex_destroy(&regex);
+    }
+
+    if (failed == 0)
+        i_check(TRUE, "random", "all", CHECK_TEXT);
+    arrst_destroy(&matches, NULL, uint32_t);
+    return failed;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the flush in the middle of a walk, before it a single find never returned */
+static uint32_t i_wide(const uint32_t size)
+{
+    char_t *text = cast(malloc(size + 1), char_t);
+    RegEx *regex = regex_create(CHECK_WIDE);
+    ArrSt(uint32_t) *matches = arrst_create(uint32_t);
+    uint32_t i, n, pos, len = 0, count = 0, first = UINT32_MAX;
+    bool_t ok = TRUE;
+    cassert_no_null(regex);
+    for (i = 0; i < size; ++i)
+        text[i] = "abc"[i_rand(3)];
+    text[size] = '\0';
+
+    /* matches never overlap, each one starts past the end of the last */
+    for (i = 0; i + CHECK_WIDE_GAP < size; ++i)
+    {
+        if (text[i] == 'a' && text[i + CHECK_WIDE_GAP] == 'c')
+        {
+            if (first == UINT32_MAX)
+                first = i;
+            count += 1;
+            i += CHECK_WIDE_GAP;
+        }
+    }
+
+    pos = regex_find(regex, text, size, 0, &len);
+    ok = pos == first && (pos == UINT32_MAX || len == CHECK_WIDE_GAP + 1);
+    n = regex_find_all(regex, text, size, matches);
+    ok = ok && n == count;
+    for (i = 0; i < n && ok; ++i)
+    {
+        const uint32_t *m = arrst_get_const(matches, 2 * i, uint32_t);
+        ok = text[m[0]] == 'a' && text[m[0] + CHECK_WIDE_GAP] == 'c' && m[1] == CHECK_WIDE_GAP + 1;
+    }
+
+    arrst_destroy(&matches, NULL, uint32_t);
+    regex_destroy(&regex);
+    free(text);
+    return i_check(ok, "wide", CHECK_WIDE, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* same pattern, but nothing matches and the walk never stops for a match */
+static uint32_t i_wide_none(const uint32_t size)
+{
+    char_t *text = cast(malloc(size + 1), char_t);
+    RegEx *regex = regex_create(CHECK_WIDE);
+    uint32_t i, pos, len = 0;
+    cassert_no_null(regex);
+    for (i = 0; i < size; ++i)
+        text[i] = "ab"[i_rand(2)];
+    text[size] = '\0';
+    pos = regex_find(regex, text, size, 0, &len);
+    regex_destroy(&regex);
+    free(text);
+    return i_check(pos == UINT32_MAX, "wide, no match", CHECK_WIDE, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    uint32_t failed = 0;
+    if (argc > 1)
+        i_SEED = (uint32_t)atoi(argv[1]);
+    if (i_SEED == 0)
+        i_SEED = CHECK_SEED;
+    core_start();
+    failed += i_random();
+    failed += i_wide(6000);
+    failed += i_wide(100000);
+    failed += i_wide_none(6000);
+    failed += i_wide_none(100000);
+    core_finish();
+    return (int)failed;
+}